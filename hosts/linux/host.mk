@@ -34,6 +34,23 @@ ifeq ($(PROJ_TYPE),lib)
     CFLAGS += -fvisibility=hidden
 endif
 
+# Modem line waits are served by a watcher thread
+CFLAGS  += -pthread
+LDFLAGS += -pthread
+
+# USDT probes (requires sys/sdt.h, e.g. from systemtap-sdt-dev)
+USDT ?= 0
+ifeq ($(USDT),1)
+    CFLAGS += -DSERIAL_USDT=1
+endif
+
+# Test hooks (e.g. device root override used by benchmarks), which are not
+# meant for distributed builds
+TEST_HOOKS ?= 0
+ifeq ($(TEST_HOOKS),1)
+    CFLAGS += -DSERIAL_TEST_HOOKS=1
+endif
+
 ifeq ($(NATIVE_HOST),linux-x64)
     ifeq ($(HOST),linux-x86)
         ifeq ($(origin CROSS_COMPILE),undefined)
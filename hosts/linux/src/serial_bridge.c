@@ -0,0 +1,258 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <_serial.h>
+#include <_serial_native.h>
+
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#define __CHUNK_SIZE 65536 // Default pipe capacity
+
+typedef struct __bridge_path __bridge_path_t;
+
+// One direction of a bridge
+struct __bridge_path {
+	serial_t*             source;
+	serial_t*             destination;
+	int                   sourceFd;
+	int                   destinationFd;
+	serial_bridge_tap_t   tap;
+	void*                 tapContext;
+	serial_bridge_stats_t stats;
+};
+
+/*
+ * Both ports are watched by a single poll() (there are only three
+ * descriptors, so epoll would not save anything). Data is moved with
+ * serial_splice_to_fd(), so it does not go through user space unless a tap
+ * is installed (or the destination needs its own write path, e.g. emulated
+ * RS-485 direction control).
+*/
+struct __serial_bridge {
+	__bridge_path_t paths[2];
+	int             stopFd;     // Written by serial_bridge_stop()
+	bool            running;
+	uint64_t        startNanos; // Timestamp of first run (0 if never started)
+	pthread_mutex_t mutex;      // Protects taps, stats and running flag
+	uint8_t         buffer[__CHUNK_SIZE];
+};
+
+static void __init_path(__bridge_path_t* path, serial_t* source, int sourceFd, serial_t* destination, int destinationFd) {
+	memset(path, 0, sizeof(__bridge_path_t));
+	path->source        = source;
+	path->sourceFd      = sourceFd;
+	path->destination   = destination;
+	path->destinationFd = destinationFd;
+}
+
+static bool __forward(serial_bridge_t* bridge, serial_bridge_direction_e direction, uint64_t readyNanos) {
+	__bridge_path_t* path = &bridge->paths[direction];
+	serial_rs485_config_t rs485;
+	serial_bridge_tap_t tap;
+	void* tapContext;
+	int32_t moved;
+
+	pthread_mutex_lock(&bridge->mutex);
+	tap        = path->tap;
+	tapContext = path->tapContext;
+	pthread_mutex_unlock(&bridge->mutex);
+
+	serial_get_rs485(path->destination, &rs485);
+
+	if (!tap && !rs485.enabled) {
+		moved = serial_splice_to_fd(path->source, path->destinationFd, __CHUNK_SIZE, SERIAL_SPLICE_FLAG_NONBLOCK);
+	} else {
+		moved = serial_read_available(path->source, bridge->buffer, sizeof(bridge->buffer));
+
+		if (moved > 0) {
+			if (tap)
+				tap(tapContext, direction, bridge->buffer, (uint32_t)moved);
+
+			if (!serial_write(path->destination, bridge->buffer, (uint32_t)moved))
+				return false;
+		}
+	}
+
+	if (moved <= 0)
+		return moved == 0; // e.g. only the beginning of an escape sequence was received
+
+	uint64_t latency = _serial_native_nanos() - readyNanos;
+
+	pthread_mutex_lock(&bridge->mutex);
+	path->stats.bytes += (uint32_t)moved;
+	path->stats.transfers++;
+	path->stats.totalLatencyNanos += latency;
+	if (latency > path->stats.maxLatencyNanos)
+		path->stats.maxLatencyNanos = latency;
+	pthread_mutex_unlock(&bridge->mutex);
+
+	return true;
+}
+
+SERIAL_PUBLIC serial_bridge_t* SERIAL_CALL serial_bridge_new(serial_t* a, serial_t* b) {
+	if (!a || !b || a == b) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return NULL;
+	}
+
+	int fdA = _serial_get_fd(a);
+	int fdB = _serial_get_fd(b);
+
+	if (fdA < 0 || fdB < 0)
+		return NULL;
+
+	serial_bridge_t* bridge = malloc(sizeof(serial_bridge_t));
+
+	if (!bridge) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	bridge->stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	if (bridge->stopFd < 0) {
+		free(bridge);
+		errno = SERIAL_ERROR_IO;
+		return NULL;
+	}
+
+	__init_path(&bridge->paths[SERIAL_BRIDGE_DIRECTION_A_TO_B], a, fdA, b, fdB);
+	__init_path(&bridge->paths[SERIAL_BRIDGE_DIRECTION_B_TO_A], b, fdB, a, fdA);
+	bridge->running    = false;
+	bridge->startNanos = 0;
+	pthread_mutex_init(&bridge->mutex, NULL);
+
+	return bridge;
+}
+
+SERIAL_PUBLIC void SERIAL_CALL serial_bridge_del(serial_bridge_t* bridge) {
+	close(bridge->stopFd);
+	pthread_mutex_destroy(&bridge->mutex);
+	free(bridge);
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_set_tap(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_tap_t tap, void* context) {
+	if (direction != SERIAL_BRIDGE_DIRECTION_A_TO_B && direction != SERIAL_BRIDGE_DIRECTION_B_TO_A) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	pthread_mutex_lock(&bridge->mutex);
+	bridge->paths[direction].tap        = tap;
+	bridge->paths[direction].tapContext = context;
+	pthread_mutex_unlock(&bridge->mutex);
+
+	return true;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_run(serial_bridge_t* bridge) {
+	struct pollfd pfds[3] = {
+		{ .fd = bridge->paths[SERIAL_BRIDGE_DIRECTION_A_TO_B].sourceFd, .events = POLLIN },
+		{ .fd = bridge->paths[SERIAL_BRIDGE_DIRECTION_B_TO_A].sourceFd, .events = POLLIN },
+		{ .fd = bridge->stopFd, .events = POLLIN }
+	};
+	uint64_t counter;
+	bool result = false;
+
+	pthread_mutex_lock(&bridge->mutex);
+	if (bridge->running) {
+		pthread_mutex_unlock(&bridge->mutex);
+		errno = SERIAL_ERROR_INVALID_PARAM; // Already running on another thread
+		return false;
+	}
+
+	bridge->running = true;
+	if (bridge->startNanos == 0)
+		bridge->startNanos = _serial_native_nanos();
+	pthread_mutex_unlock(&bridge->mutex);
+
+	while (true) {
+		if (poll(pfds, 3, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			errno = SERIAL_ERROR_IO;
+			break;
+		}
+
+		uint64_t now = _serial_native_nanos();
+
+		if (pfds[2].revents & POLLIN) {
+			if (read(bridge->stopFd, &counter, sizeof(counter)) < 0) {
+				// Nothing to do (counter is cleared anyway)
+			}
+
+			result = true;
+			break;
+		}
+
+		if ((pfds[0].revents & POLLIN) && !__forward(bridge, SERIAL_BRIDGE_DIRECTION_A_TO_B, now))
+			break;
+
+		if ((pfds[1].revents & POLLIN) && !__forward(bridge, SERIAL_BRIDGE_DIRECTION_B_TO_A, now))
+			break;
+
+		// Hang-ups with no data left
+		if (((pfds[0].revents | pfds[1].revents) & (POLLHUP | POLLERR | POLLNVAL)) && !((pfds[0].revents | pfds[1].revents) & POLLIN)) {
+			errno = SERIAL_ERROR_IO;
+			break;
+		}
+	}
+
+	pthread_mutex_lock(&bridge->mutex);
+	bridge->running = false;
+	pthread_mutex_unlock(&bridge->mutex);
+
+	return result;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_stop(serial_bridge_t* bridge) {
+	const uint64_t signal = 1;
+
+	if (write(bridge->stopFd, &signal, sizeof(signal)) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_get_stats(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_stats_t* out) {
+	if (direction != SERIAL_BRIDGE_DIRECTION_A_TO_B && direction != SERIAL_BRIDGE_DIRECTION_B_TO_A) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	pthread_mutex_lock(&bridge->mutex);
+	*out = bridge->paths[direction].stats;
+	uint64_t elapsed = bridge->startNanos == 0 ? 0 : _serial_native_nanos() - bridge->startNanos;
+	pthread_mutex_unlock(&bridge->mutex);
+
+	out->bytesPerSecond = elapsed == 0 ? 0 : (uint64_t)((double)out->bytes * 1e9 / (double)elapsed);
+	return true;
+}
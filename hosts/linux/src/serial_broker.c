@@ -0,0 +1,731 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE // memfd_create(), accept4()
+
+#include <_serial.h>
+#include <_serial_backend.h>
+#include <_serial_native.h>
+
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define __RING_MAGIC        0x53524e47 // "SRNG"
+#define __RING_MIN_SIZE     4096
+#define __RING_MAX_SIZE     (1u << 30)
+#define __RING_DEFAULT_SIZE (1u << 20)
+#define __MAX_PUBLISH       65536 // Largest read published at once
+#define __MAX_PACKET        4096  // Largest TX message (larger writes are split)
+#define __MAX_EVENTS        16
+
+typedef struct __ring __ring_t;
+typedef struct __broker_client __broker_client_t;
+typedef struct __broker_port __broker_port_t;
+
+/*
+ * Shared memory ring (memfd) holding received data. The broker reserves
+ * space before overwriting old data and commits it afterwards, so readers
+ * (which map the ring read-only and never block the broker) can tell data
+ * overwritten while it was being copied. Readers sleep on a futex which is
+ * woken on every commit (readers cannot register as waiters on a read-only
+ * mapping), so fan-out to any number of readers costs a single read from
+ * the port plus a single wake-up call.
+*/
+struct __ring {
+	uint32_t magic;
+	uint32_t capacity;  // Data size in bytes (power of 2)
+	uint64_t reserved;  // Bytes written (or being written) since creation
+	uint64_t committed; // Bytes written since creation
+	uint32_t sequence;  // Futex word (incremented on every commit)
+	uint32_t closed;    // Broker has stopped
+	uint8_t  data[];
+};
+
+// Clients are tagged on epoll by their address (first member is the socket)
+struct __broker_client {
+	int                fd;
+	__broker_client_t* next;
+};
+
+struct __serial_broker {
+	serial_t*          port;
+	int                portFd;
+	int                listenFd;
+	int                stopFd;     // Written by serial_broker_stop()
+	int                epollFd;
+	int                ringFd;
+	int                readOnlyFd; // Ring descriptor handed to clients
+	char*              socketPath;
+	__ring_t*          ring;
+	size_t             ringBytes;
+	__broker_client_t* clients;
+};
+
+// Client side (broker:// port)
+struct __broker_port {
+	int       fd; // Socket connected to the broker
+	__ring_t* ring;
+	size_t    ringBytes;
+	uint64_t  tail; // Bytes consumed
+	uint32_t  readTimeout;
+};
+
+static int __futex(uint32_t* word, int op, uint32_t value, const struct timespec* timeout) {
+	return (int)syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
+
+static uint32_t __ring_size(uint32_t requested) {
+	uint32_t size = __RING_MIN_SIZE;
+
+	if (requested == 0)
+		return __RING_DEFAULT_SIZE;
+
+	while (size < requested && size < __RING_MAX_SIZE)
+		size *= 2;
+
+	return size;
+}
+
+static bool __fill_address(struct sockaddr_un* address, const char* path) {
+	if (strlen(path) >= sizeof(address->sun_path)) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	memset(address, 0, sizeof(struct sockaddr_un));
+	address->sun_family = AF_UNIX;
+	strcpy(address->sun_path, path);
+	return true;
+}
+
+static int __listen(const char* path) {
+	struct sockaddr_un address;
+	int fd = -1;
+
+	if (!__fill_address(&address, path))
+		return -1;
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (fd < 0)
+		goto error;
+
+	// A stale socket (left by a broker which was killed) is replaced, but a
+	// live one is not.
+	if (connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0) {
+		close(fd);
+		errno = SERIAL_ERROR_ACCESS;
+		return -1;
+	}
+
+	if (errno == ECONNREFUSED) {
+		struct stat st;
+
+		// connect() is refused by non-socket files as well, which must not
+		// be replaced.
+		if (lstat(path, &st) == 0 && !S_ISSOCK(st.st_mode)) {
+			close(fd);
+			errno = SERIAL_ERROR_INVALID_PARAM;
+			return -1;
+		}
+
+		unlink(path);
+	}
+
+	if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0)
+		goto error;
+
+	return fd;
+
+error:
+	errno = errno == EACCES ? SERIAL_ERROR_ACCESS : SERIAL_ERROR_IO;
+
+	if (fd >= 0)
+		close(fd);
+
+	return -1;
+}
+
+static bool __epoll_add(int epollFd, int fd, void* tag) {
+	struct epoll_event event = { .events = EPOLLIN, .data.ptr = tag };
+	return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+SERIAL_PUBLIC serial_broker_t* SERIAL_CALL serial_broker_new(serial_t* port, const char* socketPath, uint32_t ringSize) {
+	char path[64];
+
+	if (!port || !socketPath) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return NULL;
+	}
+
+	int portFd = _serial_get_fd(port);
+
+	if (portFd < 0)
+		return NULL;
+
+	serial_broker_t* broker = malloc(sizeof(serial_broker_t));
+
+	if (!broker) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(broker, 0, sizeof(serial_broker_t));
+	broker->port       = port;
+	broker->portFd     = portFd;
+	broker->listenFd   = -1;
+	broker->stopFd     = -1;
+	broker->epollFd    = -1;
+	broker->ringFd     = -1;
+	broker->readOnlyFd = -1;
+	broker->ring       = MAP_FAILED;
+
+	if (!(broker->socketPath = strdup(socketPath))) {
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	uint32_t capacity = __ring_size(ringSize);
+	broker->ringBytes = sizeof(__ring_t) + capacity;
+
+	// Ring cannot be resized by clients (which receive a read-only descriptor)
+	broker->ringFd = memfd_create("serial-broker", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+
+	if (broker->ringFd < 0
+		|| ftruncate(broker->ringFd, (off_t)broker->ringBytes) < 0
+		|| fcntl(broker->ringFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) {
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	broker->ring = mmap(NULL, broker->ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, broker->ringFd, 0);
+
+	if (broker->ring == MAP_FAILED) {
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	broker->ring->magic    = __RING_MAGIC;
+	broker->ring->capacity = capacity;
+
+	// Reopening the memfd creates a new (read-only) open file description
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", broker->ringFd);
+	broker->readOnlyFd = open(path, O_RDONLY | O_CLOEXEC);
+
+	if (broker->readOnlyFd < 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	if ((broker->listenFd = __listen(socketPath)) < 0)
+		goto error;
+
+	broker->stopFd  = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	broker->epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (broker->stopFd < 0 || broker->epollFd < 0
+		|| !__epoll_add(broker->epollFd, portFd, &broker->portFd)
+		|| !__epoll_add(broker->epollFd, broker->listenFd, &broker->listenFd)
+		|| !__epoll_add(broker->epollFd, broker->stopFd, &broker->stopFd)) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	return broker;
+
+error:
+	serial_broker_del(broker);
+	return NULL;
+}
+
+static void __drop(serial_broker_t* broker, __broker_client_t* client) {
+	__broker_client_t** link = &broker->clients;
+
+	while (*link != client)
+		link = &(*link)->next;
+
+	*link = client->next;
+	close(client->fd); // Also removes it from epoll set
+	free(client);
+}
+
+SERIAL_PUBLIC void SERIAL_CALL serial_broker_del(serial_broker_t* broker) {
+	int previousError = errno;
+
+	while (broker->clients)
+		__drop(broker, broker->clients);
+
+	if (broker->listenFd >= 0) {
+		close(broker->listenFd);
+		unlink(broker->socketPath);
+	}
+
+	if (broker->ring != MAP_FAILED) {
+		// Readers still mapping the ring stop waiting for data
+		__atomic_store_n(&broker->ring->closed, 1, __ATOMIC_SEQ_CST);
+		__atomic_add_fetch(&broker->ring->sequence, 1, __ATOMIC_SEQ_CST);
+		__futex(&broker->ring->sequence, FUTEX_WAKE, INT_MAX, NULL);
+		munmap(broker->ring, broker->ringBytes);
+	}
+
+	int fds[] = { broker->stopFd, broker->epollFd, broker->ringFd, broker->readOnlyFd };
+
+	for (size_t i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+		if (fds[i] >= 0)
+			close(fds[i]);
+	}
+
+	free(broker->socketPath);
+	free(broker);
+
+	errno = previousError;
+}
+
+static void __reserve(__ring_t* ring, uint64_t end) {
+	__atomic_store_n(&ring->reserved, end, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST); // Reservation is visible before data is overwritten
+}
+
+// Reads from the port straight into the ring. Space is reserved only for
+// data already queued (reserving more would make readers which are a whole
+// ring behind skip data which is not overwritten).
+static bool __publish(serial_broker_t* broker) {
+	__ring_t* ring   = broker->ring;
+	uint64_t  head   = ring->committed; // Written only by the broker
+	uint32_t  offset = (uint32_t)(head & (ring->capacity - 1));
+	uint32_t  len    = ring->capacity - offset;
+	int32_t   available = serial_available(broker->port);
+	int32_t   mRead;
+
+	if (available < 0)
+		return false;
+
+	len = len > __MAX_PUBLISH ? __MAX_PUBLISH : len;
+	len = len > (uint32_t)available ? (uint32_t)available : len;
+
+	if (len > 0) {
+		__reserve(ring, head + len);
+		mRead = serial_read_available(broker->port, ring->data + offset, len);
+	} else {
+		// Nothing was queued: either port hung up (read fails) or data has
+		// just arrived (it is copied into the ring, which may wrap).
+		uint8_t bounce[256];
+
+		mRead = serial_read_available(broker->port, bounce, sizeof(bounce));
+
+		if (mRead > 0) {
+			uint32_t first = ring->capacity - offset;
+			first = first > (uint32_t)mRead ? (uint32_t)mRead : first;
+
+			__reserve(ring, head + (uint32_t)mRead);
+			memcpy(ring->data + offset, bounce, first);
+			memcpy(ring->data, bounce + first, (uint32_t)mRead - first);
+		}
+	}
+
+	if (mRead < 0)
+		return false;
+
+	__atomic_store_n(&ring->committed, head + (uint32_t)mRead, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&ring->reserved, head + (uint32_t)mRead, __ATOMIC_SEQ_CST);
+
+	if (mRead == 0)
+		return true;
+
+	__atomic_add_fetch(&ring->sequence, 1, __ATOMIC_SEQ_CST);
+	__futex(&ring->sequence, FUTEX_WAKE, INT_MAX, NULL);
+
+	return true;
+}
+
+static void __accept(serial_broker_t* broker) {
+	char marker = 0;
+	char control[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { .iov_base = &marker, .iov_len = sizeof(marker) };
+	struct msghdr msg = {
+		.msg_iov        = &iov,
+		.msg_iovlen     = 1,
+		.msg_control    = control,
+		.msg_controllen = sizeof(control)
+	};
+
+	int fd = accept4(broker->listenFd, NULL, NULL, SOCK_CLOEXEC);
+
+	if (fd < 0)
+		return; // e.g. client gave up meanwhile
+
+	__broker_client_t* client = malloc(sizeof(__broker_client_t));
+
+	if (!client)
+		goto error;
+
+	// Ring descriptor is handed over on connection
+	memset(control, 0, sizeof(control));
+	struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type  = SCM_RIGHTS;
+	cmsg->cmsg_len   = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(cmsg), &broker->readOnlyFd, sizeof(int));
+
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) < 0 || !__epoll_add(broker->epollFd, fd, client))
+		goto error;
+
+	client->fd      = fd;
+	client->next    = broker->clients;
+	broker->clients = client;
+	return;
+
+error:
+	free(client);
+	close(fd);
+}
+
+// Each message is written at once, so writes from different clients are
+// never interleaved. Delivery is best-effort: a message which cannot be
+// written is dropped and the client is not told (port errors are not fatal
+// to other clients, and clients never wait for the broker).
+static void __serve(serial_broker_t* broker, __broker_client_t* client) {
+	uint8_t packet[__MAX_PACKET];
+	ssize_t len = recv(client->fd, packet, sizeof(packet), MSG_DONTWAIT);
+
+	if (len < 0 && (errno == EAGAIN || errno == EINTR))
+		return;
+
+	if (len <= 0) {
+		__drop(broker, client); // Disconnected
+		return;
+	}
+
+	if (!serial_write(broker->port, packet, (uint32_t)len))
+		serial_purge(broker->port, SERIAL_PURGE_TYPE_TX); // Partially written data is discarded
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_run(serial_broker_t* broker) {
+	struct epoll_event events[__MAX_EVENTS];
+	uint64_t counter;
+
+	while (true) {
+		int count = epoll_wait(broker->epollFd, events, __MAX_EVENTS, -1);
+
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+
+			errno = SERIAL_ERROR_IO;
+			return false;
+		}
+
+		for (int i = 0; i < count; i++) {
+			void* tag = events[i].data.ptr;
+
+			if (tag == &broker->stopFd) {
+				if (read(broker->stopFd, &counter, sizeof(counter)) < 0) {
+					// Nothing to do (counter is cleared anyway)
+				}
+
+				return true;
+			}
+
+			if (tag == &broker->portFd) {
+				if (!(events[i].events & EPOLLIN)) {
+					errno = SERIAL_ERROR_IO; // Hang-up
+					return false;
+				}
+
+				if (!__publish(broker))
+					return false;
+			} else if (tag == &broker->listenFd) {
+				__accept(broker);
+			} else {
+				__serve(broker, (__broker_client_t*)tag);
+			}
+		}
+	}
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_stop(serial_broker_t* broker) {
+	const uint64_t signal = 1;
+
+	if (write(broker->stopFd, &signal, sizeof(signal)) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+// broker:// backend ===========================================================
+
+static void* __broker_open(const char* name, uint32_t flags) {
+	struct sockaddr_un address;
+	char marker;
+	char control[CMSG_SPACE(sizeof(int))];
+	struct iovec iov = { .iov_base = &marker, .iov_len = sizeof(marker) };
+	struct msghdr msg = {
+		.msg_iov        = &iov,
+		.msg_iovlen     = 1,
+		.msg_control    = control,
+		.msg_controllen = sizeof(control)
+	};
+	struct stat st;
+	int ringFd = -1;
+
+	if (!__fill_address(&address, name))
+		return NULL;
+
+	__broker_port_t* port = malloc(sizeof(__broker_port_t));
+
+	if (!port) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(port, 0, sizeof(__broker_port_t));
+	port->ring = MAP_FAILED;
+	port->fd   = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+
+	if (port->fd < 0 || connect(port->fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
+		errno = (errno == ENOENT || errno == ECONNREFUSED) ? SERIAL_ERROR_NOT_FOUND : (errno == EACCES ? SERIAL_ERROR_ACCESS : SERIAL_ERROR_IO);
+		goto error;
+	}
+
+	if (recvmsg(port->fd, &msg, MSG_CMSG_CLOEXEC) <= 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+
+	if (!cmsg || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	memcpy(&ringFd, CMSG_DATA(cmsg), sizeof(int));
+
+	if (fstat(ringFd, &st) < 0 || (size_t)st.st_size < sizeof(__ring_t)) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	port->ringBytes = (size_t)st.st_size;
+	port->ring      = mmap(NULL, port->ringBytes, PROT_READ, MAP_SHARED, ringFd, 0);
+	close(ringFd);
+
+	if (port->ring == MAP_FAILED || port->ring->magic != __RING_MAGIC || sizeof(__ring_t) + port->ring->capacity > port->ringBytes) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	// Like a real port, only data received after open is delivered
+	port->tail = __atomic_load_n(&port->ring->committed, __ATOMIC_SEQ_CST);
+	return port;
+
+error:
+	if (port->ring != MAP_FAILED)
+		munmap(port->ring, port->ringBytes);
+	else if (ringFd >= 0)
+		close(ringFd);
+
+	if (port->fd >= 0)
+		close(port->fd);
+
+	free(port);
+	return NULL;
+}
+
+static bool __broker_config(void* nativePort, const serial_config_t* config) {
+	return true; // Port configuration is owned by the broker
+}
+
+static bool __broker_set_read_timeout(void* nativePort, uint32_t millis) {
+	((__broker_port_t*)nativePort)->readTimeout = millis;
+	return true;
+}
+
+static bool __broker_purge(void* nativePort, serial_purge_type_e type) {
+	__broker_port_t* port = (__broker_port_t*)nativePort;
+
+	switch (type) {
+	case SERIAL_PURGE_TYPE_RX:
+	case SERIAL_PURGE_TYPE_RX_TX:
+		port->tail = __atomic_load_n(&port->ring->committed, __ATOMIC_SEQ_CST);
+		break;
+
+	case SERIAL_PURGE_TYPE_TX:
+		break; // Data is handed over to the broker at once
+
+	default:
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	return true;
+}
+
+static bool __broker_close(void* nativePort) {
+	__broker_port_t* port = (__broker_port_t*)nativePort;
+
+	munmap(port->ring, port->ringBytes);
+	close(port->fd);
+	free(port);
+	return true;
+}
+
+static int32_t __broker_available(const void* nativePort) {
+	const __broker_port_t* port = (const __broker_port_t*)nativePort;
+	uint64_t available = __atomic_load_n(&port->ring->committed, __ATOMIC_SEQ_CST) - port->tail;
+
+	// Data older than ring capacity was lost (see __take())
+	available = available > port->ring->capacity ? port->ring->capacity : available;
+	return available > INT32_MAX ? INT32_MAX : (int32_t)available;
+}
+
+// Copies committed data (readers which fall behind by more than ring
+// capacity lose the oldest data)
+static int32_t __take(__broker_port_t* port, uint8_t* out, uint32_t len) {
+	__ring_t* ring = port->ring;
+	uint32_t  mask = ring->capacity - 1;
+
+	while (true) {
+		uint64_t head = __atomic_load_n(&ring->committed, __ATOMIC_SEQ_CST);
+
+		if (head - port->tail > ring->capacity)
+			port->tail = head - ring->capacity;
+
+		uint64_t pending = head - port->tail;
+		uint32_t mRead   = pending > len ? len : (uint32_t)pending;
+		uint32_t offset  = (uint32_t)(port->tail & mask);
+		uint32_t first   = ring->capacity - offset;
+
+		first = first > mRead ? mRead : first;
+		memcpy(out, ring->data + offset, first);
+		memcpy(out + first, ring->data, mRead - first);
+
+		// Copied data is valid only if broker did not start overwriting it
+		// (copy must complete before reservation is checked)
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		uint64_t reserved = __atomic_load_n(&ring->reserved, __ATOMIC_SEQ_CST);
+
+		if (reserved - port->tail <= ring->capacity) {
+			port->tail += mRead;
+			return (int32_t)mRead;
+		}
+
+		port->tail = reserved - ring->capacity;
+	}
+}
+
+// Detects brokers which were killed (ring was not flagged as closed)
+static bool __broker_alive(const __broker_port_t* port) {
+	struct pollfd pfd = { .fd = port->fd, .events = 0 };
+
+	if (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLHUP | POLLERR))) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+static int32_t __broker_read(void* nativePort, void* out, uint32_t len) {
+	__broker_port_t* port = (__broker_port_t*)nativePort;
+	__ring_t* ring = port->ring;
+	uint64_t timestamp = _serial_native_nanos();
+
+	while (true) {
+		uint32_t sequence = __atomic_load_n(&ring->sequence, __ATOMIC_SEQ_CST);
+		int32_t mRead = __take(port, out, len);
+
+		if (mRead > 0)
+			return mRead;
+
+		if (__atomic_load_n(&ring->closed, __ATOMIC_SEQ_CST)) {
+			errno = SERIAL_ERROR_IO; // Broker has stopped
+			return -1;
+		}
+
+		uint64_t elapsed = _serial_native_nanos() - timestamp;
+		uint64_t timeout = port->readTimeout * 1000000ull;
+
+		if (elapsed >= timeout)
+			return __broker_alive(port) ? 0 : -1; // Timeout
+
+		struct timespec remaining = {
+			.tv_sec  = (time_t)((timeout - elapsed) / 1000000000ull),
+			.tv_nsec = (long)((timeout - elapsed) % 1000000000ull)
+		};
+
+		// Sleeps only if no commit happened since sequence was read
+		__futex(&ring->sequence, FUTEX_WAIT, sequence, &remaining);
+	}
+}
+
+static int32_t __broker_write(void* nativePort, const void* in, uint32_t len) {
+	__broker_port_t* port = (__broker_port_t*)nativePort;
+	ssize_t sent;
+
+	do {
+		sent = send(port->fd, in, len > __MAX_PACKET ? __MAX_PACKET : len, MSG_NOSIGNAL);
+	} while (sent < 0 && errno == EINTR);
+
+	if (sent < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return (int32_t)sent;
+}
+
+static bool __broker_flush(void* nativePort) {
+	return true; // Data is handed over to the broker at once
+}
+
+const _serial_backend_t _serial_broker_backend = {
+	.scheme           = "broker://",
+	.list_ports       = NULL,
+	.open             = __broker_open,
+	.config           = __broker_config,
+	.set_read_timeout = __broker_set_read_timeout,
+	.purge            = __broker_purge,
+	.close            = __broker_close,
+	.available        = __broker_available,
+	.read             = __broker_read,
+	.write            = __broker_write,
+	.flush            = __broker_flush
+};
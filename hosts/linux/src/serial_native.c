@@ -20,7 +20,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#define _GNU_SOURCE // ptsname_r(), splice()
+
 #include <_serial_native.h>
+#include <_serial_trace.h>
 
 #include <stdlib.h>
 #include <errno.h>
@@ -28,6 +31,7 @@ SOFTWARE.
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/sysmacros.h>
 #include <fcntl.h>
 #include <termios.h>
 #include <sys/ioctl.h>
@@ -38,15 +42,81 @@ SOFTWARE.
 #include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
+#include <poll.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <linux/serial.h>
 
 #define __PORT_BASE "/dev"
+#define __PORT_BASE_ENV "LIBSERIAL_DEV_ROOT"
+#define __SYS_BASE "/sys"
+#define __SYS_BASE_ENV "LIBSERIAL_SYS_ROOT"
 #define __PORT_NAME_PATTERN "(ttyS|ttyUSB|ttyACM|ttyAMA|rfcomm|ttyO)[0-9]{1,3}"
 
+#define __DEFAULT_BAUD      9600
+#define __DEFAULT_CHAR_BITS 10 // 8N1
+#define __OUTPUT_LINES (SERIAL_LINE_DTR | SERIAL_LINE_RTS)
+#define __INPUT_LINES  (SERIAL_LINE_CTS | SERIAL_LINE_DSR | SERIAL_LINE_RI | SERIAL_LINE_CD)
+
+#define __LINE_POLL_MILLIS 5 // Interval between transition counter reads (see __line_watch_run())
+#define __ECHO_IDLE_MILLIS 10 // Time given to own echo to arrive (see __discard_echo())
+
+typedef struct __line_watch __line_watch_t;
+
+typedef struct __drain_watch __drain_watch_t;
+
 typedef struct __linux_port __linux_port_t;
 
+/*
+ * Input line changes are watched by a dedicated thread, which publishes
+ * transition counters (TIOCGICOUNT) to waiters and signals an eventfd for
+ * event loops. TIOCMIWAIT is not used: it blocks without a timeout and can
+ * only be interrupted by a signal, so counters are read periodically instead
+ * and the thread waits on stopFd in between.
+*/
+struct __line_watch {
+	pthread_t                     thread;
+	pthread_mutex_t               mutex;
+	pthread_cond_t                cond;
+	int                           eventFd;
+	int                           stopFd; // Written on close to stop the thread
+	struct serial_icounter_struct count;  // Latest published transition counters
+	bool                          failed; // Watching stopped due to an error
+};
+
+/*
+ * Drains are requested to a dedicated thread (so nobody else is parked in
+ * tcdrain()), which signals an eventfd when done.
+*/
+struct __drain_watch {
+	pthread_t thread;
+	int       requestFd; // Written by requesters (pending requests are coalesced)
+	int       eventFd;   // Written by the thread after each drain
+};
+
 struct __linux_port {
-	int      fd;
-	uint32_t readTimeout;
+	int                   fd;
+	uint32_t              readTimeout;
+	bool                  isTty;         // Termios settings apply only to terminals
+	bool                  isSocket;      // Written with send() (see __write())
+	bool                  keepFd;        // Descriptor is not closed by _serial_native_close()
+	__line_watch_t*       lineWatch;     // Created on first line wait (NULL otherwise)
+	__drain_watch_t*      drainWatch;    // Created on first asynchronous flush (NULL otherwise)
+	uint64_t              charNanos;     // Time to send a single character with current configuration
+	bool                  rs485Emulated; // RS-485 direction control is done by the library
+	serial_rs485_config_t rs485;
+	bool                  noEcho;        // Last emulated RS-485 write was not echoed (see __discard_echo())
+	uint8_t*              held;          // Data received before an emulated RS-485 write (see __discard_echo())
+	uint32_t              heldLen;
+	uint32_t              heldPos;       // Held bytes already read
+	bool                  markErrors;    // Received data contains PARMRK escape sequences
+	uint8_t               markState;     // Bytes of an escape sequence already read (see __unmark())
+	int                   breaks;        // Breaks already delivered (compared with driver's break counter)
+	int                   splicePipe[2]; // Created on first splice to a non-pipe descriptor (-1 otherwise)
+	bool                  noSplice;      // Driver does not support splice()
 };
 
 static uint64_t __millis() {
@@ -65,77 +135,105 @@ static uint64_t __millis() {
 	return (uint32_t)now - mStart;
 }
 
+static uint64_t __char_nanos(uint32_t bits, uint32_t baud) {
+	return baud == 0 ? 0 : (bits * 1000000000ull + baud - 1) / baud;
+}
+
 static bool __regex_match(const regex_t* regex, const char* str) {
 	return regexec(regex, str, 0, NULL, 0) == 0;
 }
 
-static bool __exists(const char* path, struct stat* out) {
-	static struct stat mStat;
-
-	bool errnoWasZero = errno == 0;
-	if (stat(path, out == NULL ? &mStat : out) < 0) {
-		if (errno == ENOENT) {
-			if (errnoWasZero) {
-				errno = 0;
-			}
-			return false;
-		} else {
-			errno = SERIAL_ERROR_IO;
-			return false;
-		}
-	}
+// Prevents the driver from dropping DTR/RTS on last close. Boards which
+// reset on DTR assertion (e.g. Arduino) are then kept running across opens.
+static bool __clear_hupcl(int fd, struct termios* settings) {
+	if (!(settings->c_cflag & HUPCL))
+		return true;
 
-	return true;
+	settings->c_cflag &= ~HUPCL;
+	return tcsetattr(fd, TCSANOW, settings) == 0;
 }
 
-static bool __path_is_dir(const char* path) {
-	struct stat pathStat;
+static const char* __base(const char* defaultBase, const char* env) {
+#if SERIAL_TEST_HOOKS
+	// Scan roots can be overridden by tests and benchmarks (see TEST_HOOKS)
+	const char* base = getenv(env);
 
-	if (!__exists(path, &pathStat))
-		return false;
+	if (base && *base)
+		return base;
+#else
+	(void)env;
+#endif
 
-	return S_ISDIR(pathStat.st_mode);
+	return defaultBase;
 }
 
-static bool __path_is_char_file(const char* path) {
+// Checks if given path is a terminal backed by a device, through sysfs.
+// Ports are not opened: opening and closing an idle port toggles its modem
+// lines, which resets some boards (e.g. Arduino).
+static bool __probe(const char* path) {
 	struct stat pathStat;
+	char sysPath[512];
+	const char* sysBase = __base(__SYS_BASE, __SYS_BASE_ENV);
+
+	if (stat(path, &pathStat) < 0 || !S_ISCHR(pathStat.st_mode))
+		return false;
 
-	if (!__exists(path, &pathStat))
+	unsigned int devMajor = major(pathStat.st_rdev);
+	unsigned int devMinor = minor(pathStat.st_rdev);
+
+	// Virtual terminals and pseudo-terminals have no device
+	if (snprintf(sysPath, sizeof(sysPath), "%s/dev/char/%u:%u/device", sysBase, devMajor, devMinor) >= (int)sizeof(sysPath) || access(sysPath, F_OK) < 0)
 		return false;
 
-	return S_ISCHR(pathStat.st_mode);
+	// Serial core reports ports without hardware (e.g. unused legacy UARTs)
+	// as PORT_UNKNOWN. Other drivers (e.g. USB ones) do not report a type.
+	snprintf(sysPath, sizeof(sysPath), "%s/dev/char/%u:%u/type", sysBase, devMajor, devMinor);
+
+	FILE* typeFile = fopen(sysPath, "re");
+
+	if (!typeFile)
+		return true;
+
+	unsigned int type;
+	bool result = fscanf(typeFile, "%u", &type) != 1 || type != PORT_UNKNOWN;
+
+	fclose(typeFile);
+	return result;
 }
 
 static serial_list_t* __serial_native_list_unix_ports(serial_list_t* list, const char* namePattern) {
 	regex_t regex;
 	DIR* dir = NULL;
 	char portName[512];
-	void* nativePort;
+	const char* portBase = __base(__PORT_BASE, __PORT_BASE_ENV);
 
-	if (regcomp(&regex, namePattern, REG_EXTENDED)) {
+	if (regcomp(&regex, namePattern, REG_EXTENDED | REG_NOSUB)) {
 		errno = SERIAL_ERROR_INVALID_PARAM;
 		return false;
 	}
 
-	if (!__exists(__PORT_BASE, NULL)) {
-		errno = SERIAL_ERROR_NOT_FOUND;
-		list = NULL;
-		goto clean_up;
-	}
+	int previousError = errno;
 
-	if (!__path_is_dir(__PORT_BASE)) {
-		errno = SERIAL_ERROR_INVALID_PARAM;
-		list = NULL;
-		goto clean_up;
-	}
+	if (!(dir = opendir(portBase))) {
+		switch (errno) {
+		case ENOENT:
+			errno = SERIAL_ERROR_NOT_FOUND;
+			break;
+
+		case ENOTDIR:
+			errno = SERIAL_ERROR_INVALID_PARAM;
+			break;
+
+		default:
+			errno = SERIAL_ERROR_IO;
+			break;
+		}
 
-	if (!(dir = opendir(__PORT_BASE))) {
 		list = NULL;
 		goto clean_up;
 	}
 
 	struct dirent *dirEntry;
-	int previousError = errno;
 	while(true) {
 		dirEntry = readdir(dir);
 
@@ -146,32 +244,35 @@ static serial_list_t* __serial_native_list_unix_ports(serial_list_t* list, const
 
 		const char* filename = dirEntry->d_name;
 
-		if (strcmp(".", filename) == 0 || strcmp("..", filename) == 0)
+		// Cheap checks first: name pattern, then entry type (as reported
+		// by the file system, links being checked by __probe()).
+		if (!__regex_match(&regex, filename))
+			continue;
+
+		switch (dirEntry->d_type) {
+		case DT_CHR:
+		case DT_LNK:
+		case DT_UNKNOWN:
+			break;
+
+		default:
 			continue;
+		}
 
-		if (snprintf(portName, sizeof(portName) - 1, "%s/%s", __PORT_BASE, filename) > (sizeof(portName) - 1)) {
+		if (snprintf(portName, sizeof(portName) - 1, "%s/%s", portBase, filename) > (sizeof(portName) - 1)) {
 			// Truncated filename (buffer size is not enough)
 			errno = SERIAL_ERROR_MEM;
 			list = NULL;
 			goto clean_up;
 		}
 
-		if (__path_is_char_file(portName) && __regex_match(&regex, filename)) {
-			if ((nativePort =_serial_native_open(portName)) != NULL) {
-				if (_serial_native_close(nativePort)) {
-					if (!_serial_list_add(list, portName)) {
-						list = NULL;
-						goto clean_up;
-					}
-				} else {
-					list = NULL;
-					goto clean_up;
-				}
-			} else {
-				if (previousError == 0) {
-					errno = 0; // Ignore errors caused by open()
-				}
+		if (__probe(portName)) {
+			if (!_serial_list_add(list, portName)) {
+				list = NULL;
+				goto clean_up;
 			}
+		} else {
+			errno = previousError; // Ignore errors caused by stat()/fopen()
 		}
 	}
 
@@ -308,17 +409,28 @@ static bool __set_data_bits(struct termios* termios, serial_data_bits_e dataBits
 static bool __set_parity(struct termios* termios, serial_parity_e parity) {
 	switch (parity) {
 	case SERIAL_PARITY_NONE:
-		termios->c_cflag &= ~PARENB;
+		termios->c_cflag &= ~(PARENB | CMSPAR);
 		break;
 
 	case SERIAL_PARITY_EVEN:
 		termios->c_cflag |= PARENB;
-		termios->c_cflag &= ~PARODD;
+		termios->c_cflag &= ~(PARODD | CMSPAR);
 		break;
 
 	case SERIAL_PARITY_ODD:
-		termios->c_cflag |= PARENB;
-		termios->c_cflag |= PARODD;
+		termios->c_cflag |= PARENB | PARODD;
+		termios->c_cflag &= ~CMSPAR;
+		break;
+
+	// Stick parity: PARODD selects the level of the parity bit
+	case SERIAL_PARITY_MARK:
+		termios->c_cflag |= PARENB | CMSPAR | PARODD;
+		break;
+
+	case SERIAL_PARITY_SPACE:
+		termios->c_cflag |= PARENB | CMSPAR;
+		termios->c_cflag &= ~PARODD;
+		break;
 
 	default:
 		errno = SERIAL_ERROR_INVALID_PARAM;
@@ -348,7 +460,11 @@ static bool __set_stop_bits(struct termios* termios, serial_stop_bits_e stopBits
 }
 
 static bool __set_cfg(int fd, const struct termios* cfg) {
-	if (tcsetattr(fd, TCSANOW, cfg) < 0) {
+	SERIAL_TRACE_START(native_setattr);
+	int result = tcsetattr(fd, TCSANOW, cfg);
+	SERIAL_TRACE(native_setattr, fd, result, SERIAL_TRACE_ELAPSED(native_setattr));
+
+	if (result < 0) {
 		errno = SERIAL_ERROR_IO;
 		return false;
 	}
@@ -360,11 +476,111 @@ serial_list_t* _serial_native_list_ports(serial_list_t* list) {
 	return __serial_native_list_unix_ports(list, __PORT_NAME_PATTERN);
 }
 
-void* _serial_native_open(const char* portName) {
+static void __set_open_error() {
+	switch(errno) {
+	case EACCES:
+		errno = SERIAL_ERROR_ACCESS;
+		break;
+
+	case ENOENT:
+		errno = SERIAL_ERROR_NOT_FOUND;
+		break;
+
+	case ENOMEM:
+		errno = SERIAL_ERROR_MEM;
+		break;
+
+	case EINVAL:
+	case EBADF:
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		break;
+
+	default:
+		errno = SERIAL_ERROR_IO;
+		break;
+	}
+}
+
+static bool __set_blocking(int fd) {
+	int flags;
+	if ((flags = fcntl(fd, F_GETFL, 0)) < 0)
+		return false;
+
+	flags &= ~O_NDELAY;
+	return fcntl(fd, F_SETFL, flags) == 0;
+}
+
+static bool __is_socket(int fd) {
+	struct stat st;
+	return fstat(fd, &st) == 0 && S_ISSOCK(st.st_mode);
+}
+
+// Descriptors given to _serial_native_open_fd() share their status flags with
+// the caller (so O_NONBLOCK is left as is): transfers wait for them instead.
+static bool __wait_fd(int fd, short events, int timeout) {
+	struct pollfd pfd = { .fd = fd, .events = events };
+	int result;
+
+	do {
+		result = poll(&pfd, 1, timeout);
+	} while (result < 0 && errno == EINTR);
+
+	return result > 0;
+}
+
+// Writing to a socket whose peer is gone must fail instead of raising SIGPIPE
+static ssize_t __write(int fd, bool isSocket, const void* in, size_t len) {
+	ssize_t result;
+
+	do {
+		result = isSocket ? send(fd, in, len, MSG_NOSIGNAL) : write(fd, in, len);
+	} while (result < 0 && (errno == EINTR || (errno == EAGAIN && __wait_fd(fd, POLLOUT, -1))));
+
+	return result;
+}
+
+static bool __is_pty_master(int fd) {
+	// Termios requests on a master end are applied to the slave one (and
+	// master's own VMIN/VTIME are not honored), so master is handled as a
+	// non-terminal descriptor.
+	unsigned int ptyNumber;
+	return ioctl(fd, TIOCGPTN, &ptyNumber) == 0;
+}
+
+static bool __discard_input(int fd) {
+	uint8_t buffer[256];
+	struct pollfd pfd = { .fd = fd, .events = POLLIN };
+
+	while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+		if (read(fd, buffer, sizeof(buffer)) <= 0)
+			break;
+	}
+
+	return true;
+}
+
+void* _serial_native_open(const char* portName, uint32_t flags) {
 	__linux_port_t* port = malloc(sizeof(__linux_port_t));
 
 	if (!port) goto error;
 	port->readTimeout = 0;
+	port->isTty       = true;
+	port->isSocket    = false;
+	port->keepFd      = false;
+	port->lineWatch   = NULL;
+	port->drainWatch  = NULL;
+	port->charNanos   = __char_nanos(__DEFAULT_CHAR_BITS, __DEFAULT_BAUD);
+	port->rs485Emulated = false;
+	port->noEcho        = false;
+	port->held          = NULL;
+	port->heldLen       = 0;
+	port->heldPos       = 0;
+	port->markErrors    = false;
+	port->markState     = 0;
+	port->breaks        = 0;
+	port->splicePipe[0] = -1;
+	port->splicePipe[1] = -1;
+	port->noSplice      = false;
 
 	int previousError;
 
@@ -377,12 +593,10 @@ void* _serial_native_open(const char* portName) {
 	if (tcgetattr(port->fd, &settings) < 0)
 		goto error;
 
-	int flags;
-	if ((flags = fcntl(port->fd, F_GETFL, 0)) < 0)
+	if ((flags & SERIAL_OPEN_FLAG_NO_RESET) && !__clear_hupcl(port->fd, &settings))
 		goto error;
 
-	flags &= ~O_NDELAY; // Restores blocking mode after open
-	if (fcntl(port->fd, F_SETFL, flags) < 0)
+	if (!__set_blocking(port->fd)) // Restores blocking mode after open
 		goto error;
 
 	return port;
@@ -399,35 +613,103 @@ error:
 	}
 
 	errno = previousError; // Discards any error caused by close()
+	__set_open_error();
 
-	switch(errno) {
-	case EACCES:
-		errno = SERIAL_ERROR_ACCESS;
-		break;
+	return NULL;
+}
 
-	case ENOENT:
-		errno = SERIAL_ERROR_NOT_FOUND;
-		break;
+void* _serial_native_open_fd(int fd, uint32_t flags) {
+	__linux_port_t* port = NULL;
+	int previousError;
 
-	case ENOMEM:
-		errno = SERIAL_ERROR_MEM;
-		break;
+	if (fcntl(fd, F_GETFL, 0) < 0)
+		goto error;
 
-	case EINVAL:
-		errno = SERIAL_ERROR_INVALID_PARAM;
-		break;
+	if (!(port = malloc(sizeof(__linux_port_t))))
+		goto error;
 
-	default:
-		errno = SERIAL_ERROR_IO;
-		break;
+	port->fd          = fd;
+	port->readTimeout = 0;
+	port->isTty       = isatty(fd) && !__is_pty_master(fd);
+	port->isSocket    = __is_socket(fd);
+	port->keepFd      = (flags & SERIAL_OPEN_FLAG_KEEP_FD) != 0;
+	port->lineWatch   = NULL;
+	port->drainWatch  = NULL;
+	port->charNanos   = __char_nanos(__DEFAULT_CHAR_BITS, __DEFAULT_BAUD);
+	port->rs485Emulated = false;
+	port->noEcho        = false;
+	port->held          = NULL;
+	port->heldLen       = 0;
+	port->heldPos       = 0;
+	port->markErrors    = false;
+	port->markState     = 0;
+	port->breaks        = 0;
+	port->splicePipe[0] = -1;
+	port->splicePipe[1] = -1;
+	port->noSplice      = false;
+
+	if (port->isTty && (flags & SERIAL_OPEN_FLAG_NO_RESET)) {
+		struct termios settings;
+
+		if (tcgetattr(fd, &settings) < 0 || !__clear_hupcl(fd, &settings))
+			goto error;
 	}
 
+	return port;
+
+error:
+	previousError = errno;
+
+	free(port);
+
+	if (!(flags & SERIAL_OPEN_FLAG_KEEP_FD) && fd >= 0)
+		close(fd);
+
+	errno = previousError; // Discards any error caused by close()
+	__set_open_error();
+
 	return NULL;
 }
 
+int _serial_native_open_pty(char* slaveNameOut, size_t szSlaveName) {
+	int fd = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (fd < 0)
+		goto error;
+
+	if (grantpt(fd) < 0 || unlockpt(fd) < 0)
+		goto error;
+
+	if (ptsname_r(fd, slaveNameOut, szSlaveName) != 0)
+		goto error;
+
+	// Pairs carry binary data, so XON/XOFF bytes must not be swallowed
+	// (termios requests on master end act on the slave one).
+	struct termios settings;
+	if (tcgetattr(fd, &settings) < 0)
+		goto error;
+
+	settings.c_iflag &= ~(IXON | IXOFF | IXANY);
+
+	if (tcsetattr(fd, TCSANOW, &settings) < 0)
+		goto error;
+
+	return fd;
+
+error:
+	if (fd >= 0)
+		close(fd);
+
+	errno = SERIAL_ERROR_IO;
+	return -1;
+}
+
 bool _serial_native_config(void* nativePort, const serial_config_t* config) {
 	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
 
+	if (!linuxPort->isTty)
+		return true; // Nothing to configure (e.g. pipes and sockets)
+
 	struct termios termios;
 
 	if (!__get_cfg(linuxPort->fd, &termios))
@@ -441,12 +723,122 @@ bool _serial_native_config(void* nativePort, const serial_config_t* config) {
 	if (!result)
 		return false;
 
-	return __set_cfg(linuxPort->fd, &termios);
+	if (!__set_cfg(linuxPort->fd, &termios))
+		return false;
+
+	uint32_t charBits = 1 + config->dataBits + (config->parity != SERIAL_PARITY_NONE ? 1 : 0) + (config->stopBits == SERIAL_STOP_BITS_1 ? 1 : 2);
+	linuxPort->charNanos = __char_nanos(charBits, config->baud);
+
+	return true;
+}
+
+static void __set_lines_error() {
+	switch (errno) {
+	case ENOTTY:
+	case EINVAL:
+		errno = SERIAL_ERROR_NOT_SUPPORTED; // e.g. pseudo-terminals
+		break;
+
+	default:
+		errno = SERIAL_ERROR_IO;
+		break;
+	}
+}
+
+static bool __set_rts(int fd, bool level) {
+	int rts = TIOCM_RTS;
+	return ioctl(fd, level ? TIOCMBIS : TIOCMBIC, &rts) == 0;
+}
+
+bool _serial_native_set_rs485(void* nativePort, const serial_rs485_config_t* config) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	struct serial_rs485 rs485;
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	memset(&rs485, 0, sizeof(rs485));
+
+	if (config->enabled) {
+		rs485.flags |= SER_RS485_ENABLED;
+		rs485.flags |= config->rtsOnSend ? SER_RS485_RTS_ON_SEND : SER_RS485_RTS_AFTER_SEND;
+		rs485.flags |= config->rxDuringTx ? SER_RS485_RX_DURING_TX : 0;
+		rs485.delay_rts_before_send = config->delayBeforeSend;
+		rs485.delay_rts_after_send  = config->delayAfterSend;
+	}
+
+	// Driver support is preferred (RTS is toggled from the transmitter interrupt)
+	if (ioctl(linuxPort->fd, TIOCSRS485, &rs485) == 0) {
+		linuxPort->rs485Emulated = false;
+		linuxPort->rs485         = *config;
+		return true;
+	}
+
+	if (errno != ENOTTY && errno != EINVAL) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	// Emulation: transmitter starts disabled
+	if (config->enabled && !__set_rts(linuxPort->fd, !config->rtsOnSend)) {
+		__set_lines_error();
+		return false;
+	}
+
+	linuxPort->rs485Emulated = config->enabled;
+	linuxPort->rs485         = *config;
+	linuxPort->noEcho        = false;
+	return true;
+}
+
+// Breaks counted so far will never be delivered (e.g. discarded data)
+static void __sync_breaks(__linux_port_t* port) {
+	struct serial_icounter_struct count;
+
+	if (ioctl(port->fd, TIOCGICOUNT, &count) == 0)
+		port->breaks = count.brk;
+}
+
+bool _serial_native_mark_errors(void* nativePort, bool enabled) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	struct termios termios;
+
+	if (!__get_cfg(linuxPort->fd, &termios))
+		return false;
+
+	// Flags are kept by further configurations (see __get_cfg())
+	if (enabled) {
+		termios.c_iflag |= INPCK | PARMRK;
+		termios.c_iflag &= ~(IGNPAR | IGNBRK | BRKINT);
+	} else {
+		termios.c_iflag &= ~(INPCK | PARMRK);
+	}
+
+	if (!__set_cfg(linuxPort->fd, &termios))
+		return false;
+
+	linuxPort->markErrors = enabled;
+	linuxPort->markState  = 0;
+	__sync_breaks(linuxPort);
+	return true;
 }
 
 bool _serial_native_set_read_timeout(void* nativePort, uint32_t millis) {
 	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
 
+	if (!linuxPort->isTty) {
+		linuxPort->readTimeout = millis; // Handled by poll() on read
+		return true;
+	}
+
 	struct termios termios;
 
 	if (!__get_cfg(linuxPort->fd, &termios))
@@ -490,73 +882,904 @@ bool _serial_native_purge(void* nativePort, serial_purge_type_e type) {
 			return false;
 	}
 
+	if (!linuxPort->isTty)
+		return unixPurgeType == TCOFLUSH || __discard_input(linuxPort->fd);
+
 	if (tcflush(linuxPort->fd, unixPurgeType) < 0) {
 		errno = SERIAL_ERROR_IO;
 		return false;
 	}
 
-	return true;
-}
-
-bool _serial_native_close(void* nativePort) {
-	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	if (unixPurgeType != TCOFLUSH) {
+		linuxPort->heldLen = 0;
+		linuxPort->heldPos = 0;
+	}
 
-	if (close(linuxPort->fd) < 0) {
-		errno = SERIAL_ERROR_IO;
-		return false;
+	if (linuxPort->markErrors && unixPurgeType != TCOFLUSH) {
+		linuxPort->markState = 0;
+		__sync_breaks(linuxPort);
 	}
 
-	free(nativePort);
 	return true;
 }
 
-int32_t _serial_native_available(const void* nativePort) {
-	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+// Counters of input lines only (error counters are not relevant)
+static bool __counts_differ(const struct serial_icounter_struct* a, const struct serial_icounter_struct* b) {
+	return a->cts != b->cts || a->dsr != b->dsr || a->rng != b->rng || a->dcd != b->dcd;
+}
 
-	int32_t bytes;
+static void* __line_watch_run(void* arg) {
+	__linux_port_t* port = (__linux_port_t*)arg;
+	__line_watch_t* watch = port->lineWatch;
+	struct serial_icounter_struct published = watch->count;
+	struct pollfd pfd = { .fd = watch->stopFd, .events = POLLIN };
+	const uint64_t signal = 1;
 
-	if (ioctl(linuxPort->fd, FIONREAD, &bytes) < 0) {
-		errno = SERIAL_ERROR_IO;
-		return -1;
-	}
+	while (true) {
+		// Wakes up every __LINE_POLL_MILLIS until stopFd is signaled
+		int result = poll(&pfd, 1, __LINE_POLL_MILLIS);
 
-	return bytes;
-}
+		if (result > 0)
+			break; // Stop requested
 
-int32_t _serial_native_read(void* nativePort, void* out, uint32_t len) {
-	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+		struct serial_icounter_struct count;
+		bool failed = (result < 0 && errno != EINTR) || ioctl(port->fd, TIOCGICOUNT, &count) < 0;
 
-	uint32_t maxRef = (SIZE_MAX > INT32_MAX) ? INT32_MAX : SIZE_MAX;
-	int32_t mRead;
-	uint64_t timestamp;
+		if (!failed && !__counts_differ(&count, &published))
+			continue;
 
-	// On linux, maximum read timeout is 25.5 seconds (see termios.cc_cc).
-	// Workaround to accept longer timeouts.
+		pthread_mutex_lock(&watch->mutex);
+		if (failed) {
+			watch->failed = true;
+		} else {
+			watch->count = count;
+			published = count;
+		}
+		pthread_cond_broadcast(&watch->cond);
+		pthread_mutex_unlock(&watch->mutex);
+
+		if (write(watch->eventFd, &signal, sizeof(signal)) < 0) {
+			// Counter overflow only (descriptor is non-blocking)
+		}
+
+		if (failed)
+			break;
+	}
+
+	return NULL;
+}
+
+static __line_watch_t* __get_line_watch(__linux_port_t* port) {
+	if (port->lineWatch)
+		return port->lineWatch;
+
+	if (!port->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return NULL;
+	}
+
+	__line_watch_t* watch = malloc(sizeof(__line_watch_t));
+	pthread_condattr_t condAttr;
+
+	if (!watch) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(watch, 0, sizeof(__line_watch_t));
+	watch->eventFd = -1;
+	watch->stopFd  = -1;
+
+	// Drivers unable to count transitions are not able to wait for them either
+	if (ioctl(port->fd, TIOCGICOUNT, &watch->count) < 0) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		goto error;
+	}
+
+	if ((watch->eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0 || (watch->stopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) < 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	pthread_condattr_init(&condAttr);
+	pthread_condattr_setclock(&condAttr, CLOCK_MONOTONIC);
+	pthread_cond_init(&watch->cond, &condAttr);
+	pthread_condattr_destroy(&condAttr);
+	pthread_mutex_init(&watch->mutex, NULL);
+
+	port->lineWatch = watch;
+
+	if (pthread_create(&watch->thread, NULL, __line_watch_run, port) != 0) {
+		port->lineWatch = NULL;
+		pthread_cond_destroy(&watch->cond);
+		pthread_mutex_destroy(&watch->mutex);
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	return watch;
+
+error:
+	if (watch->eventFd >= 0)
+		close(watch->eventFd);
+
+	if (watch->stopFd >= 0)
+		close(watch->stopFd);
+
+	free(watch);
+	return NULL;
+}
+
+static void __line_watch_stop(__line_watch_t* watch) {
+	const uint64_t signal = 1;
+
+	// Thread never blocks for longer than __LINE_POLL_MILLIS between checks
+	if (write(watch->stopFd, &signal, sizeof(signal)) < 0) {
+		// Counter overflow only (descriptor is non-blocking)
+	}
+
+	pthread_join(watch->thread, NULL);
+
+	pthread_cond_destroy(&watch->cond);
+	pthread_mutex_destroy(&watch->mutex);
+	close(watch->eventFd);
+	close(watch->stopFd);
+	free(watch);
+}
+
+static void* __drain_watch_run(void* arg) {
+	__linux_port_t* port = (__linux_port_t*)arg;
+	__drain_watch_t* watch = port->drainWatch;
+	const uint64_t signal = 1;
+	uint64_t requests;
+
+	// Thread is cancelled while blocked in read() or tcdrain()
+	while (true) {
+		if (read(watch->requestFd, &requests, sizeof(requests)) < 0) {
+			if (errno == EINTR)
+				continue;
+
+			return NULL;
+		}
+
+		_serial_native_flush(port); // Errors are reported by further operations
+
+		if (write(watch->eventFd, &signal, sizeof(signal)) < 0) {
+			// Counter overflow only (descriptor is non-blocking)
+		}
+	}
+}
+
+static __drain_watch_t* __get_drain_watch(__linux_port_t* port) {
+	if (port->drainWatch)
+		return port->drainWatch;
+
+	__drain_watch_t* watch = malloc(sizeof(__drain_watch_t));
+
+	if (!watch) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	watch->requestFd = eventfd(0, EFD_CLOEXEC);
+	watch->eventFd   = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+	if (watch->requestFd < 0 || watch->eventFd < 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	port->drainWatch = watch;
+
+	if (pthread_create(&watch->thread, NULL, __drain_watch_run, port) != 0) {
+		port->drainWatch = NULL;
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	return watch;
+
+error:
+	if (watch->requestFd >= 0)
+		close(watch->requestFd);
+
+	if (watch->eventFd >= 0)
+		close(watch->eventFd);
+
+	free(watch);
+	return NULL;
+}
+
+static void __drain_watch_stop(__drain_watch_t* watch) {
+	pthread_cancel(watch->thread);
+	pthread_join(watch->thread, NULL);
+
+	close(watch->requestFd);
+	close(watch->eventFd);
+	free(watch);
+}
+
+bool _serial_native_close(void* nativePort) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	if (linuxPort->lineWatch) {
+		__line_watch_stop(linuxPort->lineWatch);
+		linuxPort->lineWatch = NULL;
+	}
+
+	if (linuxPort->drainWatch) {
+		__drain_watch_stop(linuxPort->drainWatch);
+		linuxPort->drainWatch = NULL;
+	}
+
+	if (linuxPort->splicePipe[0] >= 0) {
+		close(linuxPort->splicePipe[0]);
+		close(linuxPort->splicePipe[1]);
+	}
+
+	free(linuxPort->held);
+
+	if (!linuxPort->keepFd && close(linuxPort->fd) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	free(nativePort);
+	return true;
+}
+
+int32_t _serial_native_available(const void* nativePort) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	int32_t bytes;
+
+	if (ioctl(linuxPort->fd, FIONREAD, &bytes) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return bytes + (int32_t)(linuxPort->heldLen - linuxPort->heldPos);
+}
+
+// Moves held data (see __discard_echo()) to out (or drops it when out is NULL)
+static uint32_t __take_held(__linux_port_t* port, void* out, uint32_t len) {
+	uint32_t count = port->heldLen - port->heldPos;
+	count = count > len ? len : count;
+
+	if (out)
+		memcpy(out, port->held + port->heldPos, count);
+
+	port->heldPos += count;
+
+	if (port->heldPos == port->heldLen) {
+		port->heldLen = 0;
+		port->heldPos = 0;
+	}
+
+	return count;
+}
+
+// With VTIME = 0, poll() on a terminal reports input only when VMIN bytes
+// are buffered, so the caller is woken up once instead of on every byte.
+static bool __set_vmin(__linux_port_t* port, uint8_t vmin) {
+	struct termios termios;
+
+	if (!__get_cfg(port->fd, &termios))
+		return false;
+
+	uint32_t decis = port->readTimeout / 100;
+
+	termios.c_cc[VTIME] = vmin > 0 ? 0 : (decis > UINT8_MAX ? UINT8_MAX : decis);
+	termios.c_cc[VMIN]  = vmin;
+
+	return __set_cfg(port->fd, &termios);
+}
+
+int32_t _serial_native_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	struct pollfd pfd = { .fd = linuxPort->fd, .events = POLLIN };
+	uint64_t timestamp = __millis();
+	bool tuned = false;
+	int32_t available;
+
+	while (true) {
+		available = _serial_native_available(nativePort);
+
+		if (available < 0 || (uint32_t)available >= minBytes)
+			break;
+
+		uint64_t elapsed = __millis() - timestamp;
+
+		if (timeoutMillis != UINT32_MAX && elapsed >= timeoutMillis) {
+			errno = SERIAL_ERROR_TIMEOUT;
+			available = -1;
+			break;
+		}
+
+		if (linuxPort->isTty && !tuned) {
+			uint32_t vmin = minBytes - (linuxPort->heldLen - linuxPort->heldPos); // Held data is not seen by the driver
+
+			if (!__set_vmin(linuxPort, vmin > UINT8_MAX ? UINT8_MAX : (uint8_t)vmin)) {
+				available = -1;
+				break;
+			}
+
+			tuned = true;
+			continue; // Data may have arrived meanwhile
+		}
+
+		uint64_t remaining = timeoutMillis == UINT32_MAX ? UINT64_MAX : timeoutMillis - elapsed;
+		int result = poll(&pfd, 1, remaining > INT32_MAX ? -1 : (int)remaining);
+
+		if (result < 0 && errno != EINTR) {
+			errno = SERIAL_ERROR_IO;
+			available = -1;
+			break;
+		}
+
+		if (result > 0 && (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+			// Peer hung up (or descriptor failed): no further data will be
+			// received, so whatever is left is returned.
+			available = (pfd.revents & POLLIN) ? _serial_native_available(nativePort) : 0;
+
+			if (available <= 0) {
+				errno = SERIAL_ERROR_IO;
+				available = -1;
+			}
+
+			break;
+		}
+
+		if (result > 0 && (!linuxPort->isTty || minBytes > UINT8_MAX)) {
+			// No (further) wake-up threshold: waits for missing bytes to be
+			// received before checking again.
+			available = _serial_native_available(nativePort);
+			if (available >= 0 && (uint32_t)available < minBytes) {
+				uint64_t nanos = (uint64_t)(minBytes - (uint32_t)available) * linuxPort->charNanos;
+				nanos = nanos < 1000000 ? 1000000 : nanos;
+				nanos = (timeoutMillis != UINT32_MAX && nanos > remaining * 1000000) ? remaining * 1000000 : nanos;
+				_serial_native_sleep(nanos);
+			}
+		}
+	}
+
+	if (tuned) {
+		int error = errno;
+
+		if (!__set_vmin(linuxPort, 0))
+			return -1;
+
+		errno = error;
+	}
+
+	return available;
+}
+
+static int32_t __read(__linux_port_t* linuxPort, void* out, uint32_t len) {
+	uint32_t maxRef = (SIZE_MAX > INT32_MAX) ? INT32_MAX : SIZE_MAX;
+	int32_t mRead;
+	uint64_t timestamp;
+
+	if (linuxPort->heldLen > 0)
+		return (int32_t)__take_held(linuxPort, out, len > maxRef ? maxRef : len);
+
+	if (!linuxPort->isTty) {
+		struct pollfd pfd = { .fd = linuxPort->fd, .events = POLLIN };
+		int timeout = linuxPort->readTimeout > INT32_MAX ? -1 : (int)linuxPort->readTimeout;
+		int result = poll(&pfd, 1, timeout);
+
+		if (result == 0)
+			return 0; // Timeout
+
+		if (result < 0)
+			goto error;
+
+		mRead = read(linuxPort->fd, out, len > maxRef ? maxRef : len);
+		SERIAL_TRACE(native_read, linuxPort->fd, len, mRead);
+
+		if (mRead < 0 && errno == EAGAIN)
+			return 0; // Non-blocking descriptor: data was taken by someone else
+
+		if (mRead <= 0) // Error or end-of-file (peer closed the descriptor)
+			goto error;
+
+		return mRead;
+	}
+
+	// On linux, maximum read timeout is 25.5 seconds (see termios.cc_cc).
+	// Workaround to accept longer timeouts.
 	timestamp = __millis();
 	while (true) {
 		mRead = read(linuxPort->fd, out, len > maxRef ? maxRef : len);
-		if (mRead == 0) {
+		SERIAL_TRACE(native_read, linuxPort->fd, len, mRead);
+		if (mRead < 0 && errno == EAGAIN) {
+			// Non-blocking descriptor: VTIME is not honored
+			uint64_t elapsed = __millis() - timestamp;
+			uint64_t remaining = elapsed >= linuxPort->readTimeout ? 0 : linuxPort->readTimeout - elapsed;
+
+			if (remaining == 0 || !__wait_fd(linuxPort->fd, POLLIN, remaining > INT32_MAX ? -1 : (int)remaining)) {
+				mRead = 0;
+				break;
+			}
+		} else if (mRead == 0) {
 			if ((__millis() - timestamp) >= linuxPort->readTimeout) {
 				break;
 			}
-		} else {
+		} else {
+			break;
+		}
+	}
+
+	if (mRead < 0)
+		goto error;
+
+	return mRead;
+
+error:
+	errno = SERIAL_ERROR_IO;
+	return -1;
+}
+
+// A break and a zero byte received with a framing error share the same
+// escape sequence, so they are told apart through driver's break counter.
+static bool __is_break(__linux_port_t* port) {
+	struct serial_icounter_struct count;
+
+	if (ioctl(port->fd, TIOCGICOUNT, &count) < 0)
+		return true; // For the UART, a framing error on a zero byte is a break
+
+	if (count.brk - port->breaks <= 0)
+		return false;
+
+	port->breaks++;
+	return true;
+}
+
+/*
+ * Decodes PARMRK escape sequences in place: "\377\377" is a valid 0xFF byte
+ * and "\377\0<c>" is a byte <c> received with a parity/framing error (a
+ * break is received as "\377\0\0"). Sequences may be split across reads.
+*/
+static uint32_t __unmark(__linux_port_t* port, uint8_t* data, uint32_t len, uint8_t* errorMap, uint8_t* breakMap, uint32_t firstBit) {
+	uint32_t decoded = 0;
+
+	for (uint32_t i = 0; i < len; i++) {
+		uint8_t b = data[i];
+
+		switch (port->markState) {
+		case 0:
+			if (b == 0377) {
+				port->markState = 1;
+			} else {
+				data[decoded++] = b;
+			}
+			break;
+
+		case 1:
+			// Anything but "\377" or "\0" cannot follow (ISTRIP is disabled)
+			port->markState = b == 0 ? 2 : 0;
+			if (b != 0)
+				data[decoded++] = b;
+			break;
+
+		default: {
+			uint32_t bit = firstBit + decoded;
+
+			if (errorMap)
+				errorMap[bit / 8] |= (uint8_t)(1 << (bit % 8));
+
+			if (breakMap && b == 0 && __is_break(port))
+				breakMap[bit / 8] |= (uint8_t)(1 << (bit % 8));
+
+			port->markState = 0;
+			data[decoded++] = b;
+			break;
+		}
+		}
+	}
+
+	return decoded;
+}
+
+int32_t _serial_native_read_marked(void* nativePort, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap, uint32_t firstBit) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	while (true) {
+		int32_t mRead = __read(linuxPort, out, len);
+
+		if (mRead <= 0 || !linuxPort->markErrors)
+			return mRead;
+
+		mRead = (int32_t)__unmark(linuxPort, out, (uint32_t)mRead, errorMap, breakMap, firstBit);
+
+		if (mRead > 0)
+			return mRead;
+
+		// Only the beginning of an escape sequence was read (remaining bytes
+		// are already queued by the driver).
+	}
+}
+
+int32_t _serial_native_read(void* nativePort, void* out, uint32_t len) {
+	return _serial_native_read_marked(nativePort, out, len, NULL, NULL, 0);
+}
+
+int32_t _serial_native_read_available(void* nativePort, void* out, uint32_t len) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	int32_t mRead;
+
+	if (linuxPort->heldLen > 0) {
+		mRead = (int32_t)__take_held(linuxPort, out, len > INT32_MAX ? INT32_MAX : len);
+		return linuxPort->markErrors ? (int32_t)__unmark(linuxPort, out, (uint32_t)mRead, NULL, NULL, 0) : mRead;
+	}
+
+	// A single non-blocking read is issued whenever the descriptor allows it.
+	// Otherwise, its blocking mode (shared with other users of the open file
+	// description, or needed by VTIME on terminals) is left alone and data is
+	// checked for before.
+	if (linuxPort->isSocket) {
+		mRead = recv(linuxPort->fd, out, len, MSG_DONTWAIT);
+	} else if (linuxPort->isTty && linuxPort->readTimeout / 100 == 0) {
+		// VMIN = VTIME = 0: read() returns zero when nothing is buffered
+		mRead = read(linuxPort->fd, out, len);
+
+		if (mRead == 0) {
+			SERIAL_TRACE(native_read, linuxPort->fd, len, mRead);
+			return 0;
+		}
+	} else {
+		if (linuxPort->isTty) {
+			// With VMIN = 0, read() returns as soon as some data is buffered
+			if (ioctl(linuxPort->fd, FIONREAD, &mRead) < 0)
+				goto error;
+
+			if (mRead == 0)
+				return 0;
+		} else {
+			// Reports both data and hang-ups (read() returns zero on the latter)
+			struct pollfd pfd = { .fd = linuxPort->fd, .events = POLLIN };
+			int result = poll(&pfd, 1, 0);
+
+			if (result < 0)
+				goto error;
+
+			if (result == 0)
+				return 0;
+		}
+
+		mRead = read(linuxPort->fd, out, len);
+	}
+
+	SERIAL_TRACE(native_read, linuxPort->fd, len, mRead);
+
+	if (mRead < 0 && errno == EAGAIN)
+		return 0;
+
+	if (mRead <= 0) // Error or end-of-file (peer closed the descriptor)
+		goto error;
+
+	if (linuxPort->markErrors)
+		mRead = (int32_t)__unmark(linuxPort, out, (uint32_t)mRead, NULL, NULL, 0);
+
+	return mRead;
+
+error:
+	errno = SERIAL_ERROR_IO;
+	return -1;
+}
+
+static bool __is_pipe(int fd) {
+	struct stat st;
+	return fstat(fd, &st) == 0 && S_ISFIFO(st.st_mode);
+}
+
+static void __close_splice_pipe(__linux_port_t* port) {
+	close(port->splicePipe[0]);
+	close(port->splicePipe[1]);
+	port->splicePipe[0] = -1;
+	port->splicePipe[1] = -1;
+}
+
+// Moves data out of port's pipe (copying it when destination does not support splice())
+static bool __splice_out(__linux_port_t* port, int fd, uint32_t len) {
+	uint8_t buffer[4096];
+	bool copy = __is_socket(fd); // splice() into a socket may raise SIGPIPE
+
+	while (len > 0) {
+		ssize_t moved;
+
+		if (copy) {
+			moved = read(port->splicePipe[0], buffer, len > sizeof(buffer) ? sizeof(buffer) : len);
+
+			if (moved > 0 && _serial_native_fd_write(fd, buffer, (uint32_t)moved) < 0)
+				moved = -1;
+		} else {
+			moved = splice(port->splicePipe[0], NULL, fd, NULL, len, SPLICE_F_MOVE);
+
+			if (moved < 0 && errno == EINVAL) {
+				copy = true;
+				continue;
+			}
+		}
+
+		if (moved < 0 && (errno == EINTR || (errno == EAGAIN && __wait_fd(fd, POLLOUT, -1))))
+			continue;
+
+		if (moved <= 0) {
+			// Data left in the pipe would be delivered out of order
+			__close_splice_pipe(port);
+			return false;
+		}
+
+		len -= (uint32_t)moved;
+	}
+
+	return true;
+}
+
+int32_t _serial_native_splice_to_fd(void* nativePort, int fd, uint32_t len, uint32_t flags) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	struct pollfd pfd = { .fd = linuxPort->fd, .events = POLLIN };
+	ssize_t mRead;
+	int result;
+
+	// Marked data has to be decoded
+	if (linuxPort->noSplice || linuxPort->markErrors) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	// Held data is not in driver's queue (so it is copied)
+	if (linuxPort->heldLen > 0) {
+		uint32_t count = linuxPort->heldLen - linuxPort->heldPos;
+		count = count > len ? len : count;
+
+		if (_serial_native_fd_write(fd, linuxPort->held + linuxPort->heldPos, count) < 0)
+			goto error;
+
+		return (int32_t)__take_held(linuxPort, NULL, count);
+	}
+
+	bool direct = __is_pipe(fd);
+
+	if (!direct && linuxPort->splicePipe[0] < 0 && pipe2(linuxPort->splicePipe, O_CLOEXEC) < 0) {
+		errno = SERIAL_ERROR_MEM;
+		return -1;
+	}
+
+	// splice() does not honor read timeout (it blocks on empty pipes and
+	// sockets), so data is waited for before.
+	if (flags & SERIAL_SPLICE_FLAG_NONBLOCK) {
+		result = poll(&pfd, 1, 0);
+	} else {
+		do {
+			result = poll(&pfd, 1, linuxPort->readTimeout > INT32_MAX ? -1 : (int)linuxPort->readTimeout);
+		} while (result < 0 && errno == EINTR);
+	}
+
+	if (result < 0)
+		goto error;
+
+	if (result == 0)
+		return 0; // Timeout
+
+	do {
+		mRead = splice(linuxPort->fd, NULL, direct ? fd : linuxPort->splicePipe[1], NULL, len, SPLICE_F_MOVE);
+	} while (mRead < 0 && errno == EINTR);
+
+	SERIAL_TRACE(native_read, linuxPort->fd, len, (int32_t)mRead);
+
+	if (mRead < 0 && errno == EAGAIN)
+		return 0; // Non-blocking descriptor: data was taken by someone else
+
+	if (mRead < 0 && errno == EINVAL) {
+		linuxPort->noSplice = true; // Destination is a pipe, so the driver is the culprit
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	if (mRead <= 0) // Error or end-of-file (peer closed the descriptor)
+		goto error;
+
+	if (!direct && !__splice_out(linuxPort, fd, (uint32_t)mRead))
+		goto error;
+
+	return (int32_t)mRead;
+
+error:
+	errno = SERIAL_ERROR_IO;
+	return -1;
+}
+
+// Waits for the last bit to leave the wire. Sleeping for the expected drain
+// time is preferred over tcdrain(), which wakes up with a coarse granularity
+// on some drivers.
+static bool __wait_tx_done(__linux_port_t* port) {
+	int pending;
+	int previous = INT_MAX;
+
+	// Stops when queue does not move (e.g. nobody reads a pseudo-terminal)
+	while (ioctl(port->fd, TIOCOUTQ, &pending) == 0 && pending > 0 && pending < previous) {
+		_serial_native_sleep((uint64_t)pending * port->charNanos);
+		previous = pending;
+	}
+
+	if (tcdrain(port->fd) < 0)
+		return false;
+
+	// UART FIFO and shift register are not accounted by TIOCOUTQ
+	int lsr;
+	if (ioctl(port->fd, TIOCSERGETLSR, &lsr) < 0) {
+		_serial_native_sleep(port->charNanos); // e.g. USB adapters
+		return true;
+	}
+
+	while (!(lsr & TIOCSER_TEMT)) {
+		_serial_native_sleep(port->charNanos);
+
+		if (ioctl(port->fd, TIOCSERGETLSR, &lsr) < 0)
+			return false;
+	}
+
+	return true;
+}
+
+// Reads up to len bytes, waiting up to timeoutMillis for each one
+static uint32_t __read_raw(__linux_port_t* port, uint8_t* out, uint32_t len, int timeoutMillis) {
+	uint32_t total = 0;
+
+	while (total < len && __wait_fd(port->fd, POLLIN, timeoutMillis)) {
+		ssize_t mRead = read(port->fd, out + total, len - total);
+		SERIAL_TRACE(native_read, port->fd, len - total, (int32_t)mRead);
+
+		if (mRead < 0 && (errno == EINTR || errno == EAGAIN))
+			continue;
+
+		if (mRead <= 0)
+			break;
+
+		total += (uint32_t)mRead;
+	}
+
+	return total;
+}
+
+// Returns room for len more held bytes (at port->held + port->heldLen)
+static uint8_t* __hold_room(__linux_port_t* port, uint32_t len) {
+	if (port->heldPos > 0) {
+		memmove(port->held, port->held + port->heldPos, port->heldLen - port->heldPos);
+		port->heldLen -= port->heldPos;
+		port->heldPos  = 0;
+	}
+
+	uint8_t* held = realloc(port->held, port->heldLen + len);
+
+	if (!held)
+		return NULL;
+
+	port->held = held;
+	return held + port->heldLen;
+}
+
+/*
+ * Own echo is queued after data received before the write, which is held
+ * (and read before driver's queue) instead of being dropped along with the
+ * echo. Only received bytes matching written data are dropped: the first
+ * mismatching one (e.g. a reply, when the transceiver does not echo) and
+ * anything after it are held as well. Echo is waited for only while the
+ * transceiver is known to echo.
+*/
+static bool __discard_echo(__linux_port_t* port, uint32_t pending, const uint8_t* data, uint32_t written) {
+	uint8_t scratch[256];
+	uint8_t* room;
+	uint32_t echoLen = written;
+	uint32_t matched = 0;
+	uint32_t index   = 0;     // Next written byte expected
+	bool     escaped = false; // First byte of an escaped 0xff was matched
+	int timeout = __ECHO_IDLE_MILLIS + (int)(4 * port->charNanos / 1000000); // Receiver FIFO timeout
+
+	// PARMRK escapes received 0xff bytes
+	for (uint32_t i = 0; port->markErrors && i < written; i++) {
+		if (data[i] == 0xff)
+			echoLen++;
+	}
+
+	if (pending > 0) {
+		if (!(room = __hold_room(port, pending)))
+			return false;
+
+		port->heldLen += __read_raw(port, room, pending, timeout);
+	}
+
+	while (matched < echoLen) {
+		uint32_t chunk = echoLen - matched;
+		chunk = chunk > sizeof(scratch) ? sizeof(scratch) : chunk;
+
+		uint32_t mRead = __read_raw(port, scratch, chunk, port->noEcho ? 0 : timeout);
+		uint32_t i = 0;
+
+		for (; i < mRead && scratch[i] == data[index]; i++) {
+			if (port->markErrors && data[index] == 0xff && !escaped) {
+				escaped = true;
+			} else {
+				escaped = false;
+				index++;
+			}
+		}
+
+		matched += i;
+
+		if (i < mRead) {
+			// Not an echo: data is kept
+			if (!(room = __hold_room(port, mRead - i)))
+				return false;
+
+			memcpy(room, scratch + i, mRead - i);
+			port->heldLen += mRead - i;
 			break;
 		}
+
+		if (mRead < chunk)
+			break; // Echo is incomplete
+	}
+
+	port->noEcho = matched == 0 && echoLen > 0;
+	return true;
+}
+
+// RS-485 emulation: transmitter is enabled only while data is being sent
+static int32_t __rs485_write(__linux_port_t* port, const void* in, uint32_t len) {
+	const serial_rs485_config_t* rs485 = &port->rs485;
+	uint32_t written = 0;
+	int pending = 0;
+	bool result = __set_rts(port->fd, rs485->rtsOnSend);
+
+	// Data received so far is not part of own echo
+	if (result && !rs485->rxDuringTx)
+		result = ioctl(port->fd, FIONREAD, &pending) == 0;
+
+	if (result && rs485->delayBeforeSend > 0)
+		_serial_native_sleep(rs485->delayBeforeSend * 1000000ull);
+
+	while (result && written < len) {
+		ssize_t mWritten = __write(port->fd, port->isSocket, (const uint8_t*)in + written, len - written);
+		SERIAL_TRACE(native_write, port->fd, len - written, mWritten);
+
+		if (mWritten < 0)
+			result = false;
+		else if (mWritten > 0)
+			written += (uint32_t)mWritten;
 	}
 
-	if (mRead < 0) {
+	result = result && __wait_tx_done(port);
+
+	if (!rs485->rxDuringTx && !__discard_echo(port, (uint32_t)pending, in, written))
+		result = false;
+
+	if (rs485->delayAfterSend > 0)
+		_serial_native_sleep(rs485->delayAfterSend * 1000000ull);
+
+	// Bus is always released (even on errors)
+	if (!__set_rts(port->fd, !rs485->rtsOnSend))
+		result = false;
+
+	if (!result) {
 		errno = SERIAL_ERROR_IO;
 		return -1;
 	}
 
-	return mRead;
+	return (int32_t)written;
 }
 
 int32_t _serial_native_write(void* nativePort, const void* in, uint32_t len) {
 	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
 
+	if (linuxPort->rs485Emulated)
+		return __rs485_write(linuxPort, in, len);
+
 	uint32_t maxRef = (SIZE_MAX > INT32_MAX) ? INT32_MAX : SIZE_MAX;
-	ssize_t written = write(linuxPort->fd, in, len > maxRef ? maxRef : len);
+	ssize_t written = __write(linuxPort->fd, linuxPort->isSocket, in, len > maxRef ? maxRef : len);
+	SERIAL_TRACE(native_write, linuxPort->fd, len, written);
 
 	if (written < 0)
 		goto error;
@@ -568,13 +1791,359 @@ error:
 	return -1;
 }
 
+int32_t _serial_native_send_file(void* nativePort, int fd, uint64_t offset, uint32_t len) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	off_t position = (off_t)offset;
+	uint32_t sent = 0;
+
+	// RTS has to be toggled around writes, and sendfile() into a socket may
+	// raise SIGPIPE.
+	if (linuxPort->rs485Emulated || linuxPort->isSocket) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	while (sent < len) {
+		ssize_t result = sendfile(linuxPort->fd, fd, &position, len - sent);
+		SERIAL_TRACE(native_write, linuxPort->fd, len - sent, (int32_t)result);
+
+		if (result < 0 && (errno == EINTR || (errno == EAGAIN && __wait_fd(linuxPort->fd, POLLOUT, -1))))
+			continue;
+
+		if (result < 0 && sent == 0 && (errno == EINVAL || errno == ENOSYS)) {
+			errno = SERIAL_ERROR_NOT_SUPPORTED; // e.g. source is not a regular file
+			return -1;
+		}
+
+		if (result < 0) {
+			errno = SERIAL_ERROR_IO;
+			return -1;
+		}
+
+		if (result == 0)
+			break; // End of file
+
+		sent += (uint32_t)result;
+	}
+
+	return (int32_t)sent;
+}
+
+int _serial_native_flush_async(void* nativePort) {
+	__drain_watch_t* watch = __get_drain_watch((__linux_port_t*)nativePort);
+	const uint64_t request = 1;
+
+	if (!watch)
+		return -1;
+
+	if (write(watch->requestFd, &request, sizeof(request)) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return watch->eventFd;
+}
+
+int32_t _serial_native_tx_pending(const void* nativePort) {
+	const __linux_port_t* linuxPort = (const __linux_port_t*)nativePort;
+	int pending;
+
+	// Also supported by sockets (SIOCOUTQ) and pseudo-terminal masters
+	if (ioctl(linuxPort->fd, TIOCOUTQ, &pending) < 0) {
+		errno = (errno == ENOTTY || errno == EINVAL) ? SERIAL_ERROR_NOT_SUPPORTED : SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return pending;
+}
+
+bool _serial_native_write_address(void* nativePort, uint8_t address) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	struct termios termios;
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (tcgetattr(linuxPort->fd, &termios) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	tcflag_t cflag = termios.c_cflag;
+	bool result;
+
+	// Parity must not change while previous data is still being sent
+	if (!__wait_tx_done(linuxPort)) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	termios.c_cflag |= PARENB | CMSPAR | PARODD; // MARK
+	if (!__set_cfg(linuxPort->fd, &termios))
+		return false;
+
+	result = _serial_native_write(nativePort, &address, 1) == 1 && __wait_tx_done(linuxPort);
+
+	termios.c_cflag = cflag;
+	if (!__set_cfg(linuxPort->fd, &termios))
+		return false;
+
+	if (!result) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+bool _serial_native_send_break(void* nativePort, uint32_t durationMicros) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	// tcsendbreak() durations are driver-defined, hence TIOCSBRK/TIOCCBRK
+	if (!__wait_tx_done(linuxPort) || ioctl(linuxPort->fd, TIOCSBRK) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	_serial_native_sleep(durationMicros * 1000ull);
+
+	if (ioctl(linuxPort->fd, TIOCCBRK) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
 bool _serial_native_flush(void* nativePort) {
 	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
 
-	if (tcdrain(linuxPort->fd) < 0) {
+	if (!linuxPort->isTty)
+		return true;
+
+	SERIAL_TRACE_START(native_drain);
+	int result = tcdrain(linuxPort->fd);
+	SERIAL_TRACE(native_drain, linuxPort->fd, result, SERIAL_TRACE_ELAPSED(native_drain));
+
+	if (result < 0) {
 		errno = SERIAL_ERROR_IO;
 		return false;
 	}
 
 	return true;
 }
+
+static int __to_tiocm(uint32_t lines) {
+	int tiocm = 0;
+
+	if (lines & SERIAL_LINE_DTR) tiocm |= TIOCM_DTR;
+	if (lines & SERIAL_LINE_RTS) tiocm |= TIOCM_RTS;
+	if (lines & SERIAL_LINE_CTS) tiocm |= TIOCM_CTS;
+	if (lines & SERIAL_LINE_DSR) tiocm |= TIOCM_DSR;
+	if (lines & SERIAL_LINE_RI)  tiocm |= TIOCM_RNG;
+	if (lines & SERIAL_LINE_CD)  tiocm |= TIOCM_CAR;
+
+	return tiocm;
+}
+
+static int32_t __from_tiocm(int tiocm) {
+	int32_t lines = 0;
+
+	if (tiocm & TIOCM_DTR) lines |= SERIAL_LINE_DTR;
+	if (tiocm & TIOCM_RTS) lines |= SERIAL_LINE_RTS;
+	if (tiocm & TIOCM_CTS) lines |= SERIAL_LINE_CTS;
+	if (tiocm & TIOCM_DSR) lines |= SERIAL_LINE_DSR;
+	if (tiocm & TIOCM_RNG) lines |= SERIAL_LINE_RI;
+	if (tiocm & TIOCM_CAR) lines |= SERIAL_LINE_CD;
+
+	return lines;
+}
+
+// Checks if any of given lines had a transition since 'since' snapshot
+static bool __lines_changed(const struct serial_icounter_struct* now, const struct serial_icounter_struct* since, uint32_t mask) {
+	return ((mask & SERIAL_LINE_CTS) && now->cts - since->cts > 0)
+		|| ((mask & SERIAL_LINE_DSR) && now->dsr - since->dsr > 0)
+		|| ((mask & SERIAL_LINE_RI)  && now->rng - since->rng > 0)
+		|| ((mask & SERIAL_LINE_CD)  && now->dcd - since->dcd > 0);
+}
+
+bool _serial_native_set_lines(void* nativePort, uint32_t mask, uint32_t values) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+
+	if (mask & ~__OUTPUT_LINES) {
+		errno = SERIAL_ERROR_INVALID_PARAM; // Input lines cannot be set
+		return false;
+	}
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	int set   = __to_tiocm(mask & values);
+	int clear = __to_tiocm(mask & ~values);
+
+	if ((set && ioctl(linuxPort->fd, TIOCMBIS, &set) < 0) || (clear && ioctl(linuxPort->fd, TIOCMBIC, &clear) < 0)) {
+		__set_lines_error();
+		return false;
+	}
+
+	return true;
+}
+
+int32_t _serial_native_get_lines(void* nativePort) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	int tiocm;
+
+	if (!linuxPort->isTty) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	if (ioctl(linuxPort->fd, TIOCMGET, &tiocm) < 0) {
+		__set_lines_error();
+		return -1;
+	}
+
+	return __from_tiocm(tiocm);
+}
+
+int32_t _serial_native_wait_lines(void* nativePort, uint32_t mask, uint32_t timeoutMillis) {
+	__linux_port_t* linuxPort = (__linux_port_t*)nativePort;
+	struct serial_icounter_struct since;
+	struct timespec deadline;
+	bool failed   = false;
+	bool timedOut = false;
+
+	if (mask & ~__INPUT_LINES) {
+		errno = SERIAL_ERROR_INVALID_PARAM; // Output lines are not watched
+		return -1;
+	}
+
+	if (mask == 0)
+		mask = __INPUT_LINES;
+
+	__line_watch_t* watch = __get_line_watch(linuxPort);
+	if (!watch)
+		return -1;
+
+	// Transitions are counted from now on (published counters may be late)
+	if (ioctl(linuxPort->fd, TIOCGICOUNT, &since) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+	deadline.tv_sec  += timeoutMillis / 1000;
+	deadline.tv_nsec += (long)(timeoutMillis % 1000) * 1000000L;
+	if (deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	pthread_mutex_lock(&watch->mutex);
+	while (!__lines_changed(&watch->count, &since, mask)) {
+		if (watch->failed) {
+			failed = true;
+			break;
+		}
+
+		if (timeoutMillis == UINT32_MAX) {
+			pthread_cond_wait(&watch->cond, &watch->mutex);
+		} else if (pthread_cond_timedwait(&watch->cond, &watch->mutex, &deadline) == ETIMEDOUT) {
+			timedOut = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&watch->mutex);
+
+	if (timedOut) {
+		// Transitions may not be published yet
+		struct serial_icounter_struct now;
+		timedOut = ioctl(linuxPort->fd, TIOCGICOUNT, &now) < 0 || !__lines_changed(&now, &since, mask);
+	}
+
+	if (failed) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	if (timedOut) {
+		errno = SERIAL_ERROR_TIMEOUT;
+		return -1;
+	}
+
+	return _serial_native_get_lines(nativePort);
+}
+
+int _serial_native_lines_event_fd(void* nativePort) {
+	__line_watch_t* watch = __get_line_watch((__linux_port_t*)nativePort);
+	return watch ? watch->eventFd : -1;
+}
+
+int _serial_native_get_fd(const void* nativePort) {
+	return ((const __linux_port_t*)nativePort)->fd;
+}
+
+int32_t _serial_native_fd_write(int fd, const void* in, uint32_t len) {
+	uint32_t written = 0;
+	bool isSocket = true; // Until send() tells otherwise
+
+	while (written < len) {
+		ssize_t result = __write(fd, isSocket, (const uint8_t*)in + written, len - written);
+
+		if (result < 0 && isSocket && errno == ENOTSOCK) {
+			isSocket = false;
+			continue;
+		}
+
+		if (result <= 0) {
+			errno = SERIAL_ERROR_IO;
+			return -1;
+		}
+
+		written += (uint32_t)result;
+	}
+
+	return (int32_t)written;
+}
+
+int32_t _serial_native_fd_pread(int fd, void* out, uint32_t len, uint64_t offset) {
+	ssize_t result;
+
+	do {
+		result = pread(fd, out, len, (off_t)offset);
+	} while (result < 0 && errno == EINTR);
+
+	if (result < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return (int32_t)result;
+}
+
+uint64_t _serial_native_nanos() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void _serial_native_sleep(uint64_t nanos) {
+	int previousError = errno;
+	struct timespec ts;
+
+	ts.tv_sec  = nanos / 1000000000ull;
+	ts.tv_nsec = nanos % 1000000000ull;
+
+	while (nanosleep(&ts, &ts) < 0 && errno == EINTR);
+
+	errno = previousError;
+}
@@ -0,0 +1,235 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <_serial_backend.h>
+#include <_serial_native.h>
+
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/stat.h>
+
+typedef struct __pty_port __pty_port_t;
+
+/*
+ * Master end of a new pseudo-terminal, whose slave end is published through
+ * a symbolic link (like socat's 'pty,link=<path>'), so other processes can
+ * open it by a well-known name. The slave end is kept open by the port:
+ * otherwise reads on master end fail while no peer is connected.
+*/
+struct __pty_port {
+	void* master;          // Native port on master end
+	int   slaveFd;
+	char  slaveName[128];
+	char* linkPath;
+};
+
+// Only a dangling link (left by a process which was killed: its slave end
+// is gone) is replaced. Any other file, including a live link, is not.
+static bool __link(const char* slaveName, const char* linkPath) {
+	struct stat st;
+
+	if (lstat(linkPath, &st) == 0) {
+		if (!S_ISLNK(st.st_mode) || stat(linkPath, &st) == 0) {
+			errno = SERIAL_ERROR_ACCESS;
+			return false;
+		}
+
+		unlink(linkPath);
+	}
+
+	if (symlink(slaveName, linkPath) < 0) {
+		errno = errno == EACCES ? SERIAL_ERROR_ACCESS : SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+// Link is removed only if it was not replaced meanwhile
+static void __unlink(const __pty_port_t* port) {
+	char target[sizeof(port->slaveName)];
+	ssize_t len = readlink(port->linkPath, target, sizeof(target) - 1);
+
+	if (len < 0)
+		return;
+
+	target[len] = '\0';
+
+	if (strcmp(target, port->slaveName) == 0)
+		unlink(port->linkPath);
+}
+
+static void* __pty_open(const char* name, uint32_t flags) {
+	__pty_port_t* port;
+	struct termios termios;
+	int masterFd;
+	int previousError;
+
+	if (*name == '\0') {
+		errno = SERIAL_ERROR_INVALID_PARAM; // Link path is required
+		return NULL;
+	}
+
+	if (!(port = malloc(sizeof(__pty_port_t)))) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(port, 0, sizeof(__pty_port_t));
+	port->slaveFd = -1;
+
+	if (!(port->linkPath = strdup(name))) {
+		errno = SERIAL_ERROR_MEM;
+		goto error;
+	}
+
+	if ((masterFd = _serial_native_open_pty(port->slaveName, sizeof(port->slaveName))) < 0)
+		goto error;
+
+	// Descriptor is owned by the native port from now on
+	if (!(port->master = _serial_native_open_fd(masterFd, flags & ~SERIAL_OPEN_FLAG_KEEP_FD)))
+		goto error;
+
+	// Peers get raw data even if they do not configure the port
+	port->slaveFd = open(port->slaveName, O_RDWR | O_NOCTTY | O_CLOEXEC);
+
+	if (port->slaveFd < 0 || tcgetattr(port->slaveFd, &termios) < 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	cfmakeraw(&termios);
+
+	if (tcsetattr(port->slaveFd, TCSANOW, &termios) < 0) {
+		errno = SERIAL_ERROR_IO;
+		goto error;
+	}
+
+	if (!__link(port->slaveName, port->linkPath))
+		goto error;
+
+	return port;
+
+error:
+	previousError = errno;
+
+	if (port->slaveFd >= 0)
+		close(port->slaveFd);
+
+	if (port->master)
+		_serial_native_close(port->master);
+
+	free(port->linkPath);
+	free(port);
+
+	errno = previousError; // Discards any error caused by cleanup
+	return NULL;
+}
+
+static bool __pty_close(void* nativePort) {
+	__pty_port_t* port = (__pty_port_t*)nativePort;
+
+	if (!_serial_native_close(port->master))
+		return false;
+
+	__unlink(port);
+	close(port->slaveFd);
+	free(port->linkPath);
+	free(port);
+	return true;
+}
+
+static bool __pty_config(void* nativePort, const serial_config_t* config) {
+	return _serial_native_config(((__pty_port_t*)nativePort)->master, config);
+}
+
+static bool __pty_set_read_timeout(void* nativePort, uint32_t millis) {
+	return _serial_native_set_read_timeout(((__pty_port_t*)nativePort)->master, millis);
+}
+
+static bool __pty_purge(void* nativePort, serial_purge_type_e type) {
+	return _serial_native_purge(((__pty_port_t*)nativePort)->master, type);
+}
+
+static int32_t __pty_available(const void* nativePort) {
+	return _serial_native_available(((const __pty_port_t*)nativePort)->master);
+}
+
+static int32_t __pty_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	return _serial_native_wait_readable(((__pty_port_t*)nativePort)->master, minBytes, timeoutMillis);
+}
+
+static int32_t __pty_read(void* nativePort, void* out, uint32_t len) {
+	return _serial_native_read(((__pty_port_t*)nativePort)->master, out, len);
+}
+
+static int32_t __pty_read_available(void* nativePort, void* out, uint32_t len) {
+	return _serial_native_read_available(((__pty_port_t*)nativePort)->master, out, len);
+}
+
+static int32_t __pty_splice_to_fd(void* nativePort, int fd, uint32_t len, uint32_t flags) {
+	return _serial_native_splice_to_fd(((__pty_port_t*)nativePort)->master, fd, len, flags);
+}
+
+static int32_t __pty_write(void* nativePort, const void* in, uint32_t len) {
+	return _serial_native_write(((__pty_port_t*)nativePort)->master, in, len);
+}
+
+static int32_t __pty_send_file(void* nativePort, int fd, uint64_t offset, uint32_t len) {
+	return _serial_native_send_file(((__pty_port_t*)nativePort)->master, fd, offset, len);
+}
+
+static bool __pty_flush(void* nativePort) {
+	return _serial_native_flush(((__pty_port_t*)nativePort)->master);
+}
+
+static int32_t __pty_tx_pending(const void* nativePort) {
+	return _serial_native_tx_pending(((const __pty_port_t*)nativePort)->master);
+}
+
+static int __pty_get_fd(const void* nativePort) {
+	return _serial_native_get_fd(((const __pty_port_t*)nativePort)->master);
+}
+
+const _serial_backend_t _serial_pty_backend = {
+	.scheme           = "pty://",
+	.list_ports       = NULL,
+	.open             = __pty_open,
+	.config           = __pty_config,
+	.set_read_timeout = __pty_set_read_timeout,
+	.purge            = __pty_purge,
+	.close            = __pty_close,
+	.available        = __pty_available,
+	.wait_readable    = __pty_wait_readable,
+	.read             = __pty_read,
+	.read_available   = __pty_read_available,
+	.splice_to_fd     = __pty_splice_to_fd,
+	.write            = __pty_write,
+	.send_file        = __pty_send_file,
+	.flush            = __pty_flush,
+	.tx_pending       = __pty_tx_pending,
+	.get_fd           = __pty_get_fd
+};
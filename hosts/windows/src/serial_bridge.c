@@ -0,0 +1,53 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <serial.h>
+
+// Ports are not backed by descriptors which could be spliced or polled
+// together, so bridges are not supported.
+
+SERIAL_PUBLIC serial_bridge_t* SERIAL_CALL serial_bridge_new(serial_t* a, serial_t* b) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return NULL;
+}
+
+SERIAL_PUBLIC void SERIAL_CALL serial_bridge_del(serial_bridge_t* bridge) {}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_set_tap(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_tap_t tap, void* context) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_run(serial_bridge_t* bridge) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_stop(serial_bridge_t* bridge) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_get_stats(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_stats_t* out) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
@@ -0,0 +1,55 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <_serial_backend.h>
+
+// Brokers rely on shared memory descriptors and UNIX sockets, so they are
+// not supported.
+
+SERIAL_PUBLIC serial_broker_t* SERIAL_CALL serial_broker_new(serial_t* port, const char* socketPath, uint32_t ringSize) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return NULL;
+}
+
+SERIAL_PUBLIC void SERIAL_CALL serial_broker_del(serial_broker_t* broker) {}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_run(serial_broker_t* broker) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_stop(serial_broker_t* broker) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return false;
+}
+
+static void* __broker_open(const char* name, uint32_t flags) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return NULL;
+}
+
+// Remaining operations are never called (open always fails)
+const _serial_backend_t _serial_broker_backend = {
+	.scheme           = "broker://",
+	.list_ports       = NULL,
+	.open             = __broker_open
+};
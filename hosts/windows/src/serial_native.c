@@ -23,6 +23,7 @@ SOFTWARE.
 #include <_serial_native.h>
 
 #include <windows.h>
+#include <io.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <stdio.h>
@@ -75,6 +76,14 @@ static bool __set_parity(DCB* dcb, serial_parity_e parity) {
 		dcb->Parity = ODDPARITY;
 		break;
 
+	case SERIAL_PARITY_MARK:
+		dcb->Parity = MARKPARITY;
+		break;
+
+	case SERIAL_PARITY_SPACE:
+		dcb->Parity = SPACEPARITY;
+		break;
+
 	default:
 		errno = SERIAL_ERROR_INVALID_PARAM;
 		return false;
@@ -156,7 +165,7 @@ error:
 	return NULL;
 }
 
-void* _serial_native_open(const char* portName) {
+void* _serial_native_open(const char* portName, uint32_t flags) {
 	void* nativePort = INVALID_HANDLE_VALUE;
 
 	int previousError;
@@ -210,6 +219,16 @@ error:
 	return NULL;
 }
 
+void* _serial_native_open_fd(int fd, uint32_t flags) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return NULL;
+}
+
+int _serial_native_open_pty(char* slaveNameOut, size_t szSlaveName) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
 bool _serial_native_config(void* nativePort, const serial_config_t* config) {
 	DCB dcb;
 
@@ -227,6 +246,23 @@ bool _serial_native_config(void* nativePort, const serial_config_t* config) {
 	return __set_cfg(__WIN_PORT(nativePort), &dcb);
 }
 
+bool _serial_native_set_rs485(void* nativePort, const serial_rs485_config_t* config) {
+	DCB dcb;
+
+	// RTS_CONTROL_TOGGLE asserts RTS while sending, without delays
+	if (config->enabled && (!config->rtsOnSend || config->delayBeforeSend > 0 || config->delayAfterSend > 0)) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (!__get_cfg(__WIN_PORT(nativePort), &dcb))
+		return false;
+
+	dcb.fRtsControl = config->enabled ? RTS_CONTROL_TOGGLE : RTS_CONTROL_ENABLE;
+
+	return __set_cfg(__WIN_PORT(nativePort), &dcb);
+}
+
 bool _serial_native_set_read_timeout(void* nativePort, uint32_t millis) {
 	COMMTIMEOUTS commTimeouts = { 0 };
 
@@ -293,6 +329,26 @@ int32_t _serial_native_available(const void* nativePort) {
 	}
 }
 
+int32_t _serial_native_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	uint64_t timestamp = _serial_native_nanos();
+
+	// Input queue is polled (waiting for a receive event would consume
+	// events other callers may be waiting for).
+	while (true) {
+		int32_t available = _serial_native_available(nativePort);
+
+		if (available < 0 || (uint32_t)available >= minBytes)
+			return available;
+
+		if (timeoutMillis != UINT32_MAX && (_serial_native_nanos() - timestamp) / 1000000 >= timeoutMillis) {
+			errno = SERIAL_ERROR_TIMEOUT;
+			return -1;
+		}
+
+		Sleep(1);
+	}
+}
+
 int32_t _serial_native_read(void* nativePort, void* out, uint32_t len) {
 	DWORD mRead = 0;
 
@@ -304,6 +360,30 @@ int32_t _serial_native_read(void* nativePort, void* out, uint32_t len) {
 	return (int32_t)mRead;
 }
 
+int32_t _serial_native_read_available(void* nativePort, void* out, uint32_t len) {
+	int32_t available = _serial_native_available(nativePort);
+
+	if (available <= 0)
+		return available;
+
+	// Reading no more than queued data does not block
+	return _serial_native_read(nativePort, out, (uint32_t)available < len ? (uint32_t)available : len);
+}
+
+int32_t _serial_native_splice_to_fd(void* nativePort, int fd, uint32_t len, uint32_t flags) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
+bool _serial_native_mark_errors(void* nativePort, bool enabled) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED; // Errors are not reported per byte
+	return false;
+}
+
+int32_t _serial_native_read_marked(void* nativePort, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap, uint32_t firstBit) {
+	return _serial_native_read(nativePort, out, len); // Marking is never enabled
+}
+
 int32_t _serial_native_write(void* nativePort, const void* in, uint32_t len) {
 	DWORD written;
 
@@ -315,6 +395,11 @@ int32_t _serial_native_write(void* nativePort, const void* in, uint32_t len) {
 	return (int32_t)written;
 }
 
+int32_t _serial_native_send_file(void* nativePort, int fd, uint64_t offset, uint32_t len) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
 bool _serial_native_flush(void* nativePort) {
 	if (!FlushFileBuffers(__WIN_PORT(nativePort))) {
 		errno = SERIAL_ERROR_IO;
@@ -323,3 +408,171 @@ bool _serial_native_flush(void* nativePort) {
 
 	return true;
 }
+
+bool _serial_native_set_lines(void* nativePort, uint32_t mask, uint32_t values) {
+	if (mask & ~(SERIAL_LINE_DTR | SERIAL_LINE_RTS)) {
+		errno = SERIAL_ERROR_INVALID_PARAM; // Input lines cannot be set
+		return false;
+	}
+
+	if ((mask & SERIAL_LINE_DTR) && !EscapeCommFunction(__WIN_PORT(nativePort), (values & SERIAL_LINE_DTR) ? SETDTR : CLRDTR))
+		goto error;
+
+	if ((mask & SERIAL_LINE_RTS) && !EscapeCommFunction(__WIN_PORT(nativePort), (values & SERIAL_LINE_RTS) ? SETRTS : CLRRTS))
+		goto error;
+
+	return true;
+
+error:
+	errno = SERIAL_ERROR_IO;
+	return false;
+}
+
+int32_t _serial_native_get_lines(void* nativePort) {
+	DWORD status;
+
+	// State of output lines cannot be queried (only input ones are reported)
+	if (!GetCommModemStatus(__WIN_PORT(nativePort), &status)) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	int32_t lines = 0;
+
+	if (status & MS_CTS_ON)  lines |= SERIAL_LINE_CTS;
+	if (status & MS_DSR_ON)  lines |= SERIAL_LINE_DSR;
+	if (status & MS_RING_ON) lines |= SERIAL_LINE_RI;
+	if (status & MS_RLSD_ON) lines |= SERIAL_LINE_CD;
+
+	return lines;
+}
+
+int32_t _serial_native_wait_lines(void* nativePort, uint32_t mask, uint32_t timeoutMillis) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
+int _serial_native_lines_event_fd(void* nativePort) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
+int _serial_native_flush_async(void* nativePort) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED;
+	return -1;
+}
+
+int32_t _serial_native_tx_pending(const void* nativePort) {
+	COMSTAT comStat;
+
+	if (!ClearCommError(__WIN_PORT(nativePort), NULL, &comStat)) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return (int32_t)comStat.cbOutQue;
+}
+
+bool _serial_native_write_address(void* nativePort, uint8_t address) {
+	DCB dcb;
+
+	// Parity must not change while previous data is still being sent
+	if (!FlushFileBuffers(__WIN_PORT(nativePort)) || !__get_cfg(__WIN_PORT(nativePort), &dcb)) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	BYTE parity = dcb.Parity;
+	bool result;
+
+	dcb.Parity = MARKPARITY;
+	if (!__set_cfg(__WIN_PORT(nativePort), &dcb))
+		return false;
+
+	result = _serial_native_write(nativePort, &address, 1) == 1 && FlushFileBuffers(__WIN_PORT(nativePort));
+
+	dcb.Parity = parity;
+	if (!__set_cfg(__WIN_PORT(nativePort), &dcb))
+		return false;
+
+	if (!result) {
+		errno = SERIAL_ERROR_IO;
+		return false;
+	}
+
+	return true;
+}
+
+bool _serial_native_send_break(void* nativePort, uint32_t durationMicros) {
+	if (!FlushFileBuffers(__WIN_PORT(nativePort)) || !SetCommBreak(__WIN_PORT(nativePort)))
+		goto error;
+
+	_serial_native_sleep(durationMicros * 1000ull);
+
+	if (!ClearCommBreak(__WIN_PORT(nativePort)))
+		goto error;
+
+	return true;
+
+error:
+	errno = SERIAL_ERROR_IO;
+	return false;
+}
+
+int _serial_native_get_fd(const void* nativePort) {
+	errno = SERIAL_ERROR_NOT_SUPPORTED; // Ports are handles
+	return -1;
+}
+
+int32_t _serial_native_fd_write(int fd, const void* in, uint32_t len) {
+	uint32_t written = 0;
+
+	while (written < len) {
+		int result = _write(fd, (const uint8_t*)in + written, len - written);
+
+		if (result <= 0) {
+			errno = SERIAL_ERROR_IO;
+			return -1;
+		}
+
+		written += (uint32_t)result;
+	}
+
+	return (int32_t)written;
+}
+
+int32_t _serial_native_fd_pread(int fd, void* out, uint32_t len, uint64_t offset) {
+	// NOTE: file position is changed (there is no positional read for CRT descriptors)
+	if (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	int result = _read(fd, out, len);
+
+	if (result < 0) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return result;
+}
+
+uint64_t _serial_native_nanos() {
+	static LARGE_INTEGER frequency = { 0 };
+	LARGE_INTEGER counter;
+
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	QueryPerformanceCounter(&counter);
+
+	return (uint64_t)(counter.QuadPart / frequency.QuadPart) * 1000000000ull
+		+ (uint64_t)(counter.QuadPart % frequency.QuadPart) * 1000000000ull / frequency.QuadPart;
+}
+
+void _serial_native_sleep(uint64_t nanos) {
+	// Sleep() resolution is milliseconds (rounding up to not sleep less than requested)
+	uint64_t millis = (nanos + 999999) / 1000000;
+	Sleep(millis > INFINITE - 1 ? INFINITE - 1 : (DWORD)millis);
+}
@@ -57,6 +57,19 @@ typedef struct __serial serial_t;
 
 typedef struct serial_config serial_config_t;
 
+typedef struct serial_rs485_config serial_rs485_config_t;
+
+typedef struct serial_line_emulation serial_line_emulation_t;
+typedef struct serial_line_stats serial_line_stats_t;
+
+typedef struct serial_fault_config serial_fault_config_t;
+typedef struct serial_fault_stats serial_fault_stats_t;
+
+typedef struct __serial_bridge serial_bridge_t;
+typedef struct serial_bridge_stats serial_bridge_stats_t;
+
+typedef struct __serial_broker serial_broker_t;
+
 enum serial_data_bits {
 	SERIAL_DATA_BITS_5 = 5,
 	SERIAL_DATA_BITS_6,
@@ -68,6 +81,8 @@ enum serial_parity {
 	SERIAL_PARITY_NONE = 0,
 	SERIAL_PARITY_EVEN,
 	SERIAL_PARITY_ODD,
+	SERIAL_PARITY_MARK,  // Parity bit is always 1 (e.g. address bytes on 9-bit multidrop buses)
+	SERIAL_PARITY_SPACE  // Parity bit is always 0 (e.g. data bytes on 9-bit multidrop buses)
 };
 
 enum serial_stop_bits {
@@ -90,7 +105,28 @@ enum serial_error {
 	SERIAL_ERROR_ACCESS        = -4,
 	SERIAL_ERROR_NOT_FOUND     = -5,
 	SERIAL_ERROR_INVALID_PARAM = -6,
-	SERIAL_ERROR_TIMEOUT       = -7
+	SERIAL_ERROR_TIMEOUT       = -7,
+	SERIAL_ERROR_NOT_SUPPORTED = -8
+};
+
+enum serial_open_flag {
+	SERIAL_OPEN_FLAG_NONE     = 0,
+	SERIAL_OPEN_FLAG_KEEP_FD  = 1 << 0, // serial_close() does not close the descriptor given to serial_open_fd()
+	SERIAL_OPEN_FLAG_NO_RESET = 1 << 1  // Modem lines (DTR/RTS) are not dropped on close, so next open does not reset the device
+};
+
+enum serial_line {
+	SERIAL_LINE_DTR = 1 << 0, // Data terminal ready (output)
+	SERIAL_LINE_RTS = 1 << 1, // Request to send (output)
+	SERIAL_LINE_CTS = 1 << 2, // Clear to send (input)
+	SERIAL_LINE_DSR = 1 << 3, // Data set ready (input)
+	SERIAL_LINE_RI  = 1 << 4, // Ring indicator (input)
+	SERIAL_LINE_CD  = 1 << 5  // Carrier detect (input)
+};
+
+enum serial_splice_flag {
+	SERIAL_SPLICE_FLAG_NONE     = 0,
+	SERIAL_SPLICE_FLAG_NONBLOCK = 1 << 0 // Only data already received is transferred (see serial_read_available())
 };
 
 typedef enum serial_data_bits serial_data_bits_e;
@@ -103,6 +139,12 @@ typedef enum serial_purge_type serial_purge_type_e;
 
 typedef enum serial_error serial_error_e;
 
+typedef enum serial_open_flag serial_open_flag_e;
+
+typedef enum serial_line serial_line_e;
+
+typedef enum serial_splice_flag serial_splice_flag_e;
+
 struct serial_config {
 	uint32_t           baud;
 	serial_data_bits_e dataBits;
@@ -110,6 +152,70 @@ struct serial_config {
 	serial_stop_bits_e stopBits;
 };
 
+struct serial_rs485_config {
+	bool     enabled;         // Transmitter is enabled through RTS only while sending
+	bool     rtsOnSend;       // RTS level while sending (RTS has the opposite level otherwise)
+	bool     rxDuringTx;      // Data received while sending (e.g. own echo) is kept
+	uint32_t delayBeforeSend; // Milliseconds between transmitter enable and first bit
+	uint32_t delayAfterSend;  // Milliseconds between last bit and transmitter disable
+};
+
+struct serial_line_emulation {
+	uint32_t bufferSize;    // Transmit buffer size in bytes (0: writes return only when data is on the wire)
+	uint32_t latencyMillis; // Received data is delivered on ticks of this period, like USB adapters' latency timer (0: disabled)
+	uint32_t rxBufferSize;  // Receive buffer size in bytes (0: unlimited). Bytes received while it is full are dropped (overrun)
+};
+
+struct serial_line_stats {
+	uint64_t overruns; // Received bytes dropped because receive buffer was full
+};
+
+enum serial_fault_direction {
+	SERIAL_FAULT_DIRECTION_RX = 1 << 0,
+	SERIAL_FAULT_DIRECTION_TX = 1 << 1
+};
+
+typedef enum serial_fault_direction serial_fault_direction_e;
+
+struct serial_fault_config {
+	uint64_t seed;          // PRNG seed (same seed and traffic produce the same faults)
+	uint32_t directions;    // Affected data (see serial_fault_direction_e)
+	double   bitErrorRate;  // Probability of each data bit being flipped
+	double   dropRate;      // Probability of each byte being dropped
+	double   duplicateRate; // Probability of each byte being duplicated
+	double   burstRate;     // Probability of a noise burst starting at each byte
+	uint32_t burstLength;   // Number of bytes replaced by random data on each burst
+	double   stallRate;     // Probability of each read/write operation stalling
+	uint32_t stallMillis;   // Stall duration
+};
+
+struct serial_fault_stats {
+	uint64_t bytes;      // Bytes passed through the injector
+	uint64_t bitErrors;  // Flipped bits
+	uint64_t drops;      // Dropped bytes
+	uint64_t duplicates; // Duplicated bytes
+	uint64_t bursts;     // Noise bursts
+	uint64_t burstBytes; // Bytes replaced by noise
+	uint64_t stalls;     // Stalled operations
+};
+
+enum serial_bridge_direction {
+	SERIAL_BRIDGE_DIRECTION_A_TO_B = 0,
+	SERIAL_BRIDGE_DIRECTION_B_TO_A = 1
+};
+
+typedef enum serial_bridge_direction serial_bridge_direction_e;
+
+typedef void (SERIAL_CALL *serial_bridge_tap_t)(void* context, serial_bridge_direction_e direction, const void* data, uint32_t len);
+
+struct serial_bridge_stats {
+	uint64_t bytes;             // Forwarded bytes
+	uint64_t transfers;         // Forwarding operations (each one moves data available at once)
+	uint64_t bytesPerSecond;    // Average rate since the bridge was started
+	uint64_t totalLatencyNanos; // Sum of the time between data being reported readable and being written
+	uint64_t maxLatencyNanos;   // Longest time between data being reported readable and being written
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -128,12 +234,32 @@ SERIAL_PUBLIC serial_list_t* SERIAL_CALL serial_list_ports(serial_list_t* list);
 
 SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open(const char* portName);
 
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_ex(const char* portName, uint32_t flags);
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_fd(int fd, uint32_t flags);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_create_virtual_pair(serial_t** a, serial_t** b, const char** nameA, const char** nameB);
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_line_emulation(serial_t* port, const serial_line_emulation_t* emulation);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_get_line_stats(const serial_t* port, serial_line_stats_t* out);
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_fault_injection(serial_t* port, const serial_fault_config_t* config);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_fault_config(serial_t* port, const serial_fault_config_t* config);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_get_fault_stats(const serial_t* port, serial_fault_stats_t* out);
+
 SERIAL_PUBLIC const char* SERIAL_CALL serial_get_name(const serial_t* port);
 
 SERIAL_PUBLIC bool SERIAL_CALL serial_config(serial_t* port, const serial_config_t* config);
 
 SERIAL_PUBLIC void SERIAL_CALL serial_get_config(const serial_t* port, serial_config_t* out);
 
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_rs485(serial_t* port, const serial_rs485_config_t* config);
+
+SERIAL_PUBLIC void SERIAL_CALL serial_get_rs485(const serial_t* port, serial_rs485_config_t* out);
+
 SERIAL_PUBLIC bool SERIAL_CALL serial_set_read_timeout(serial_t* port, uint32_t millis);
 
 SERIAL_PUBLIC uint32_t SERIAL_CALL serial_get_read_timeout(const serial_t* port);
@@ -144,12 +270,62 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_close(serial_t* port);
 
 SERIAL_PUBLIC int32_t SERIAL_CALL serial_available(const serial_t* port);
 
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_wait_readable(serial_t* port, uint32_t minBytes, uint32_t timeoutMillis);
+
 SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_t len);
 
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_read_available(serial_t* port, void* out, uint32_t len);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_splice_to_fd(serial_t* port, int fd, uint32_t len, uint32_t flags);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_error_marking(serial_t* port, bool enabled);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_read_marked(serial_t* port, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap);
+
 SERIAL_PUBLIC bool SERIAL_CALL serial_write(serial_t* port, const void* in, uint32_t len);
 
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_send_file(serial_t* port, int fd, uint64_t offset, uint32_t len);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_write_address(serial_t* port, uint8_t address);
+
 SERIAL_PUBLIC bool SERIAL_CALL serial_flush(serial_t* port);
 
+SERIAL_PUBLIC int SERIAL_CALL serial_flush_async(serial_t* port);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_tx_pending(const serial_t* port);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_send_break(serial_t* port, uint32_t durationMicros);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_discard(serial_t* port, uint32_t maxBytes, uint32_t idleMillis);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_lines(serial_t* port, uint32_t mask, uint32_t values);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_get_lines(serial_t* port);
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_wait_lines(serial_t* port, uint32_t mask, uint32_t timeoutMillis);
+
+SERIAL_PUBLIC int SERIAL_CALL serial_get_lines_event_fd(serial_t* port);
+
+SERIAL_PUBLIC serial_bridge_t* SERIAL_CALL serial_bridge_new(serial_t* a, serial_t* b);
+
+SERIAL_PUBLIC void SERIAL_CALL serial_bridge_del(serial_bridge_t* bridge);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_set_tap(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_tap_t tap, void* context);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_run(serial_bridge_t* bridge);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_stop(serial_bridge_t* bridge);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_bridge_get_stats(serial_bridge_t* bridge, serial_bridge_direction_e direction, serial_bridge_stats_t* out);
+
+SERIAL_PUBLIC serial_broker_t* SERIAL_CALL serial_broker_new(serial_t* port, const char* socketPath, uint32_t ringSize);
+
+SERIAL_PUBLIC void SERIAL_CALL serial_broker_del(serial_broker_t* broker);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_run(serial_broker_t* broker);
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_broker_stop(serial_broker_t* broker);
+
 SERIAL_PUBLIC const char* SERIAL_CALL serial_version();
 
 #ifdef __cplusplus
@@ -42,6 +42,17 @@ extern "C" {
 */
 const char* _serial_list_add(serial_list_t* list, const char* element);
 
+/**
+ * @brief Returns the descriptor used by a port.
+ *
+ * @param port Serial port.
+ *
+ * @return On success, returns a descriptor which can be polled for input.
+ *         Otherwise, returns a negative value (::SERIAL_ERROR_NOT_SUPPORTED
+ *         is set for backends which are not backed by a descriptor).
+*/
+int _serial_get_fd(const serial_t* port);
+
 #ifdef __cplusplus
 } // extern "C"
 #endif
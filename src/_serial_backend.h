@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief [PRIVATE] Serial port backends
+ *
+ * A backend implements the low-level operations of a port. The backend
+ * used by a port is chosen by the scheme prefix of the port name (e.g.
+ * <tt>mem://loop0</tt>). Port names without a known scheme are handled by
+ * the native backend (see _serial_native.h).
+*/
+#pragma once
+
+#include "_serial.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _serial_backend _serial_backend_t;
+
+/**
+ * @brief Backend operations.
+ *
+ * Semantics of each operation are the same of their native counterparts
+ * (see _serial_native.h). Optional operations may be \c NULL.
+*/
+struct _serial_backend {
+	/** Port name prefix handled by the backend (\c NULL for native backend). */
+	const char* scheme;
+
+	/** [OPTIONAL] Populates a list with available ports. */
+	serial_list_t* (*list_ports)(serial_list_t* list);
+
+	/** Opens a port (name is given without the scheme prefix). */
+	void* (*open)(const char* name, uint32_t flags);
+
+	bool (*config)(void* nativePort, const serial_config_t* config);
+
+	bool (*set_read_timeout)(void* nativePort, uint32_t millis);
+
+	/** [OPTIONAL] Configures RS-485 half-duplex mode. */
+	bool (*set_rs485)(void* nativePort, const serial_rs485_config_t* config);
+
+	bool (*purge)(void* nativePort, serial_purge_type_e type);
+
+	bool (*close)(void* nativePort);
+
+	int32_t (*available)(const void* nativePort);
+
+	/** [OPTIONAL] Waits until a number of bytes is available for read. */
+	int32_t (*wait_readable)(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis);
+
+	int32_t (*read)(void* nativePort, void* out, uint32_t len);
+
+	/** [OPTIONAL] Reads already received data without blocking. */
+	int32_t (*read_available)(void* nativePort, void* out, uint32_t len);
+
+	/** [OPTIONAL] Moves received data to a descriptor without user-space copies. */
+	int32_t (*splice_to_fd)(void* nativePort, int fd, uint32_t len, uint32_t flags);
+
+	int32_t (*write)(void* nativePort, const void* in, uint32_t len);
+
+	/** [OPTIONAL] Sends file contents without user-space copies. */
+	int32_t (*send_file)(void* nativePort, int fd, uint64_t offset, uint32_t len);
+
+	/** [OPTIONAL] Enables/disables marking of bytes received with errors. */
+	bool (*mark_errors)(void* nativePort, bool enabled);
+
+	/** [OPTIONAL] Same as <tt>read()</tt>, flagging bytes received with errors. */
+	int32_t (*read_marked)(void* nativePort, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap, uint32_t firstBit);
+
+	bool (*flush)(void* nativePort);
+
+	/** [OPTIONAL] Requests a drain notification (see serial_flush_async()). */
+	int (*flush_async)(void* nativePort);
+
+	/** [OPTIONAL] Returns the number of bytes waiting to be sent. */
+	int32_t (*tx_pending)(const void* nativePort);
+
+	/** [OPTIONAL] Writes a byte with the 9th (parity) bit set. */
+	bool (*write_address)(void* nativePort, uint8_t address);
+
+	/** [OPTIONAL] Sends a break after pending data. */
+	bool (*send_break)(void* nativePort, uint32_t durationMicros);
+
+	/** [OPTIONAL] Sets output modem lines (see ::serial_line_e). */
+	bool (*set_lines)(void* nativePort, uint32_t mask, uint32_t values);
+
+	/** [OPTIONAL] Returns the state of modem lines (see ::serial_line_e). */
+	int32_t (*get_lines)(void* nativePort);
+
+	/** [OPTIONAL] Waits for a change on input modem lines. */
+	int32_t (*wait_lines)(void* nativePort, uint32_t mask, uint32_t timeoutMillis);
+
+	/** [OPTIONAL] Returns a descriptor signalled on input modem line changes. */
+	int (*lines_event_fd)(void* nativePort);
+
+	/** [OPTIONAL] Returns the descriptor used by the port. */
+	int (*get_fd)(const void* nativePort);
+};
+
+/** @brief Native backend (default one). */
+extern const _serial_backend_t _serial_native_backend;
+
+/** @brief File descriptor backend (<tt>fd:&lt;number&gt;</tt>). */
+extern const _serial_backend_t _serial_fd_backend;
+
+/** @brief In-memory loopback backend (<tt>mem://&lt;name&gt;</tt>). */
+extern const _serial_backend_t _serial_mem_backend;
+
+/** @brief Mock backend completing operations instantly (<tt>null://</tt>, <tt>null://empty</tt>). */
+extern const _serial_backend_t _serial_null_backend;
+
+/** @brief Line-rate emulation backend (<tt>line://&lt;port name&gt;</tt>). */
+extern const _serial_backend_t _serial_line_backend;
+
+/** @brief Fault injection backend (<tt>fault://&lt;port name&gt;</tt>). */
+extern const _serial_backend_t _serial_fault_backend;
+
+/** @brief Broker client backend (<tt>broker://&lt;socket path&gt;</tt>, see serial_broker_new()). */
+extern const _serial_backend_t _serial_broker_backend;
+
+/** @brief Pseudo-terminal backend (<tt>pty://&lt;slave link path&gt;</tt>). */
+extern const _serial_backend_t _serial_pty_backend;
+
+/**
+ * @brief Returns the backends known by the library.
+ *
+ * @return A \c NULL-terminated array of backends. Native backend is always
+ *         the last one.
+*/
+const _serial_backend_t* const* _serial_backends();
+
+/**
+ * @brief Resolves the backend which handles given port name.
+ *
+ * @param portName Port name.
+ * @param nameOut Receives a pointer into \c portName pointing to the name
+ *        to be passed to backend's <tt>open()</tt> (scheme prefix is
+ *        skipped).
+ *
+ * @return The backend handling given port (never \c NULL).
+*/
+const _serial_backend_t* _serial_backend_find(const char* portName, const char** nameOut);
+
+/**
+ * @brief Opens a port by name.
+ *
+ * Same as serial_open(), but accepting open flags (see
+ * ::serial_open_flag_e). It is intended to be used by backends stacked on
+ * top of other ports.
+*/
+serial_t* _serial_open(const char* portName, uint32_t flags);
+
+/**
+ * @brief Creates a port on top of an already open backend port.
+ *
+ * Backend port is not touched: given configuration and read timeout must
+ * reflect its current state.
+ *
+ * @return On success, returns the new port. Otherwise, returns \c NULL
+ *         (backend port is not closed).
+*/
+serial_t* _serial_new(const _serial_backend_t* backend, void* nativePort, const char* portName, const serial_config_t* config, uint32_t readTimeout);
+
+/** @brief Returns the backend of given port. */
+const _serial_backend_t* _serial_get_backend(const serial_t* port);
+
+/** @brief Returns the backend port wrapped by given port. */
+void* _serial_get_native_port(const serial_t* port);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
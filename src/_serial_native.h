@@ -23,6 +23,9 @@ SOFTWARE.
 /**
  * @file
  * @brief [PRIVATE] Native serial interface
+ *
+ * Implemented by each host and exposed to the library through
+ * ::_serial_native_backend (see _serial_backend.h).
 */
 #pragma once
 
@@ -45,10 +48,44 @@ serial_list_t* _serial_native_list_ports(serial_list_t* list);
  * @brief Opens a native port.
  *
  * @param portName Port to be open.
+ * @param flags Open flags (see ::serial_open_flag_e).
  *
  * @return On success returns a non-null value. Otherwise, returns \c NULL.
 */
-void* _serial_native_open(const char* portName);
+void* _serial_native_open(const char* portName, uint32_t flags);
+
+/**
+ * @brief Wraps an already open file descriptor as a native port.
+ *
+ * Termios settings are skipped when descriptor does not refer to a
+ * terminal (e.g. pipes and sockets).
+ *
+ * @param fd File descriptor.
+ * @param flags Open flags (see ::serial_open_flag_e). Unless
+ *        ::SERIAL_OPEN_FLAG_KEEP_FD is given, descriptor is owned by the
+ *        port (even on failure).
+ *
+ * @return On success returns a non-null value. Otherwise, returns \c NULL
+ *         (on platforms without file descriptors, \c errno is set to
+ *         ::SERIAL_ERROR_NOT_SUPPORTED).
+*/
+void* _serial_native_open_fd(int fd, uint32_t flags);
+
+/**
+ * @brief Creates a pseudo-terminal pair.
+ *
+ * Software flow control (IXON/IXOFF/IXANY) is disabled on the pair, so
+ * binary data goes through unchanged.
+ *
+ * @param slaveNameOut Receives the path of the slave end (which can be
+ *        opened by any process).
+ * @param szSlaveName Size of \c slaveNameOut.
+ *
+ * @return On success, returns the file descriptor of master end. Otherwise,
+ *         returns a negative value (on platforms without pseudo-terminals,
+ *         \c errno is set to ::SERIAL_ERROR_NOT_SUPPORTED).
+*/
+int _serial_native_open_pty(char* slaveNameOut, size_t szSlaveName);
 
 /**
  * @brief Configures the native port
@@ -58,6 +95,20 @@ void* _serial_native_open(const char* portName);
 */
 bool _serial_native_config(void* nativePort, const serial_config_t* config);
 
+/**
+ * @brief Configures RS-485 half-duplex mode.
+ *
+ * Transmitter is enabled through RTS while data is being sent. When the
+ * driver is not able to do it, RTS is handled by the library around each
+ * write.
+ *
+ * @param nativePort Native serial port.
+ * @param config RS-485 configuration.
+ *
+ * @return A boolean indicating if operation was successful.
+*/
+bool _serial_native_set_rs485(void* nativePort, const serial_rs485_config_t* config);
+
 /**
  * @brief Sets the timeout used while reading data.
  *
@@ -98,6 +149,19 @@ bool _serial_native_close(void* nativePort);
 */
 int32_t _serial_native_available(const void* nativePort);
 
+/**
+ * @brief Waits until a number of bytes is available for read.
+ *
+ * @param nativePort Native serial port.
+ * @param minBytes Number of bytes to wait for.
+ * @param timeoutMillis Maximum time to wait (\c UINT32_MAX waits forever).
+ *
+ * @return On success, returns the number of bytes available for read
+ *         (<code>&gt;= minBytes</code>). Otherwise, returns a negative value
+ *         (::SERIAL_ERROR_TIMEOUT is set on timeout).
+*/
+int32_t _serial_native_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis);
+
 /**
  * @brief Reads data from a port.
  *
@@ -112,6 +176,69 @@ int32_t _serial_native_available(const void* nativePort);
 */
 int32_t _serial_native_read(void* nativePort, void* out, uint32_t len);
 
+/**
+ * @brief Reads data already received by a port, without blocking.
+ *
+ * @param nativePort Native serial port.
+ * @param out Buffer which will hold read data.
+ * @param len Maximum number of bytes to read (it can be safely assumed that
+ *        maximum value is \c INT32_MAX).
+ *
+ * @return On success, returns the number of bytes actually read (zero if no
+ *         data is available). Otherwise, returns a negative value (e.g.
+ *         when peer has closed the connection and no data is left).
+*/
+int32_t _serial_native_read_available(void* nativePort, void* out, uint32_t len);
+
+/**
+ * @brief Moves received data to a descriptor without user-space copies.
+ *
+ * Waits for data as _serial_native_read() does (unless
+ * ::SERIAL_SPLICE_FLAG_NONBLOCK is given).
+ *
+ * @param nativePort Native serial port.
+ * @param fd Destination descriptor.
+ * @param len Maximum number of bytes to move (it can be safely assumed that
+ *        maximum value is \c INT32_MAX).
+ * @param flags A combination of ::serial_splice_flag_e values.
+ *
+ * @return On success, returns the number of bytes moved (zero on timeout).
+ *         Otherwise, returns a negative value. If zero-copy transfer is not
+ *         possible, ::SERIAL_ERROR_NOT_SUPPORTED is set and no data is
+ *         consumed.
+*/
+int32_t _serial_native_splice_to_fd(void* nativePort, int fd, uint32_t len, uint32_t flags);
+
+/**
+ * @brief Enables/disables marking of bytes received with errors.
+ *
+ * When enabled, parity and framing errors are reported by the driver
+ * in-band and decoded by the read path (see _serial_native_read_marked()).
+ *
+ * @param nativePort Native serial port.
+ * @param enabled Defines if marking is enabled.
+ *
+ * @return A boolean indicating if operation was successful.
+*/
+bool _serial_native_mark_errors(void* nativePort, bool enabled);
+
+/**
+ * @brief Reads data from a port, flagging bytes received with errors.
+ *
+ * @param nativePort Native serial port.
+ * @param out Buffer which will hold read data.
+ * @param len Maximum number of bytes to read.
+ * @param errorMap Bitmap where each set bit flags a byte received with a
+ *        parity/framing error (or a break, received as a zero byte). Bits
+ *        are only set (never cleared). It may be \c NULL.
+ * @param breakMap Same as \c errorMap, flagging only bytes which are
+ *        actually breaks. It may be \c NULL.
+ * @param firstBit Bit in bitmaps corresponding to first byte of \c out.
+ *
+ * @return Same as _serial_native_read().
+*/
+int32_t _serial_native_read_marked(void* nativePort, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap, uint32_t firstBit);
+
 /**
  * @brief Writes data into a port.
  *
@@ -126,6 +253,22 @@ int32_t _serial_native_read(void* nativePort, void* out, uint32_t len);
 */
 int32_t _serial_native_write(void* nativePort, const void* in, uint32_t len);
 
+/**
+ * @brief Sends file contents without user-space copies.
+ *
+ * @param nativePort Native serial port.
+ * @param fd Source file descriptor (its file offset is not changed).
+ * @param offset Offset of the first byte to be sent.
+ * @param len Number of bytes to send (it can be safely assumed that maximum
+ *        value is \c INT32_MAX).
+ *
+ * @return On success, returns the number of bytes sent (less than requested
+ *         only if end-of-file was reached). Otherwise, returns a negative
+ *         value. If zero-copy transfer is not possible,
+ *         ::SERIAL_ERROR_NOT_SUPPORTED is set and no data is sent.
+*/
+int32_t _serial_native_send_file(void* nativePort, int fd, uint64_t offset, uint32_t len);
+
 /**
  * @brief Flushes any pending data.
  *
@@ -134,3 +277,152 @@ int32_t _serial_native_write(void* nativePort, const void* in, uint32_t len);
  * @return A boolean indicating if operation was successful.
 */
 bool _serial_native_flush(void* nativePort);
+
+/**
+ * @brief Sets output modem lines.
+ *
+ * @param nativePort Native serial port.
+ * @param mask Lines to be changed (only ::SERIAL_LINE_DTR and
+ *        ::SERIAL_LINE_RTS are accepted).
+ * @param values New state of the lines given in \c mask.
+ *
+ * @return A boolean indicating if operation was successful.
+*/
+bool _serial_native_set_lines(void* nativePort, uint32_t mask, uint32_t values);
+
+/**
+ * @brief Returns the state of modem lines.
+ *
+ * @param nativePort Native serial port.
+ *
+ * @return On success, returns a combination of ::serial_line_e values
+ *         (<code>&gt;= 0</code>). Otherwise, returns a negative value.
+*/
+int32_t _serial_native_get_lines(void* nativePort);
+
+/**
+ * @brief Waits for a change on input modem lines.
+ *
+ * @param nativePort Native serial port.
+ * @param mask Input lines to be watched.
+ * @param timeoutMillis Maximum time to wait (\c UINT32_MAX waits forever).
+ *
+ * @return On success, returns the state of modem lines after the change
+ *         (see _serial_native_get_lines()). Otherwise, returns a negative
+ *         value (::SERIAL_ERROR_TIMEOUT is set on timeout).
+*/
+int32_t _serial_native_wait_lines(void* nativePort, uint32_t mask, uint32_t timeoutMillis);
+
+/**
+ * @brief Returns a descriptor signalled on input modem line changes.
+ *
+ * Descriptor is owned by the port and becomes readable whenever an input
+ * line changes. It is cleared by reading an 8-byte counter from it.
+ *
+ * @param nativePort Native serial port.
+ *
+ * @return On success, returns the descriptor. Otherwise, returns a
+ *         negative value.
+*/
+int _serial_native_lines_event_fd(void* nativePort);
+
+/**
+ * @brief Requests a notification for when pending data is sent.
+ *
+ * Same as _serial_native_flush(), but without blocking the caller.
+ *
+ * @param nativePort Native serial port.
+ *
+ * @return On success, returns a descriptor owned by the port (the same on
+ *         every call) which becomes readable once data written before the
+ *         call has been sent. It is cleared by reading an 8-byte counter
+ *         from it. On error, returns a negative value.
+*/
+int _serial_native_flush_async(void* nativePort);
+
+/**
+ * @brief Returns the number of bytes waiting to be sent.
+ *
+ * @param nativePort Native serial port.
+ *
+ * @return On success, returns the number of bytes in driver's output
+ *         queue (<code>&gt;= 0</code>). Otherwise, returns a negative value.
+*/
+int32_t _serial_native_tx_pending(const void* nativePort);
+
+/**
+ * @brief Writes an address byte on a 9-bit multidrop bus.
+ *
+ * Port is expected to be configured with ::SERIAL_PARITY_MARK or
+ * ::SERIAL_PARITY_SPACE parity. Given byte is sent with the parity bit set
+ * (after pending data leaves the wire) and configured parity is restored
+ * afterwards.
+ *
+ * @param nativePort Native serial port.
+ * @param address Address byte.
+ *
+ * @return A boolean indicating if operation was successful.
+*/
+bool _serial_native_write_address(void* nativePort, uint8_t address);
+
+/**
+ * @brief Sends a break.
+ *
+ * Break is sent after pending data leaves the wire.
+ *
+ * @param nativePort Native serial port.
+ * @param durationMicros Break duration in microseconds.
+ *
+ * @return A boolean indicating if operation was successful.
+*/
+bool _serial_native_send_break(void* nativePort, uint32_t durationMicros);
+
+/**
+ * @brief Returns the descriptor used by a port.
+ *
+ * @param nativePort Native serial port.
+ *
+ * @return On success, returns the descriptor. Otherwise, returns a negative
+ *         value.
+*/
+int _serial_native_get_fd(const void* nativePort);
+
+/**
+ * @brief Writes all given data to a descriptor.
+ *
+ * @param fd Destination descriptor.
+ * @param in Data to be written.
+ * @param len Number of bytes to write.
+ *
+ * @return On success, returns the number of bytes written (always equal to
+ *         \c len). Otherwise, returns a negative value.
+*/
+int32_t _serial_native_fd_write(int fd, const void* in, uint32_t len);
+
+/**
+ * @brief Reads data from a file at given offset.
+ *
+ * @param fd Source file descriptor.
+ * @param out Buffer which will hold read data.
+ * @param len Maximum number of bytes to read.
+ * @param offset Offset of the first byte to be read.
+ *
+ * @return On success, returns the number of bytes actually read (zero at
+ *         end-of-file). Otherwise, returns a negative value.
+*/
+int32_t _serial_native_fd_pread(int fd, void* out, uint32_t len, uint64_t offset);
+
+/**
+ * @brief Returns a monotonic timestamp.
+ *
+ * @return Monotonic timestamp in nanoseconds.
+*/
+uint64_t _serial_native_nanos();
+
+/**
+ * @brief Suspends the calling thread.
+ *
+ * @param nanos Number of nanoseconds to sleep (actual resolution is
+ *        platform dependent).
+*/
+void _serial_native_sleep(uint64_t nanos);
@@ -0,0 +1,87 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/**
+ * @file
+ * @brief [PRIVATE] USDT (SystemTap/DTrace-compatible) static tracepoints
+ *
+ * Probes are compiled in only when \c SERIAL_USDT is defined (see
+ * <tt>make USDT=1</tt>). Each probe is guarded by a semaphore, so when no
+ * tracer is attached a probe site costs a single \c nop and the clock is
+ * never read.
+*/
+#pragma once
+
+/** @internal List of all probes (used to declare/define semaphores). */
+#define SERIAL_TRACE_PROBES(X) \
+	X(read)                    \
+	X(write)                   \
+	X(flush)                   \
+	X(config)                  \
+	X(timeout)                 \
+	X(native_read)             \
+	X(native_write)            \
+	X(native_drain)            \
+	X(native_setattr)
+
+#if SERIAL_USDT
+	#define _SDT_HAS_SEMAPHORES 1
+	#include <sys/sdt.h>
+	#include <stdint.h>
+	#include <time.h>
+
+	#define __SERIAL_TRACE_SEMAPHORE_DECL(probe) extern volatile unsigned short libserial_##probe##_semaphore;
+	SERIAL_TRACE_PROBES(__SERIAL_TRACE_SEMAPHORE_DECL)
+	#undef __SERIAL_TRACE_SEMAPHORE_DECL
+
+	/** @internal Defines all probe semaphores (must be used exactly once). */
+	#define SERIAL_TRACE_DEFINE_SEMAPHORES()                          \
+		SERIAL_TRACE_PROBES(__SERIAL_TRACE_SEMAPHORE_DEF)
+	#define __SERIAL_TRACE_SEMAPHORE_DEF(probe) \
+		volatile unsigned short libserial_##probe##_semaphore __attribute__((unused, section(".probes")));
+
+	/** @internal Returns a boolean indicating if a tracer is attached to given probe. */
+	#define SERIAL_TRACE_ENABLED(probe) __builtin_expect(libserial_##probe##_semaphore != 0, 0)
+
+	/** @internal Fires a probe. */
+	#define SERIAL_TRACE(probe, ...) STAP_PROBEV(libserial, probe, ##__VA_ARGS__)
+
+	/** @internal Takes a timestamp (only if a tracer is attached to given probe). */
+	#define SERIAL_TRACE_START(probe) \
+		uint64_t __traceStart_##probe = SERIAL_TRACE_ENABLED(probe) ? __serial_trace_nanos() : 0
+
+	/** @internal Nanoseconds elapsed since SERIAL_TRACE_START() (zero when not traced). */
+	#define SERIAL_TRACE_ELAPSED(probe) \
+		(__traceStart_##probe ? __serial_trace_nanos() - __traceStart_##probe : 0)
+
+	static inline uint64_t __serial_trace_nanos() {
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+	}
+#else
+	#define SERIAL_TRACE_DEFINE_SEMAPHORES()
+	#define SERIAL_TRACE_ENABLED(probe) 0
+	#define SERIAL_TRACE(probe, ...)
+	#define SERIAL_TRACE_START(probe)
+	#define SERIAL_TRACE_ELAPSED(probe) 0
+#endif
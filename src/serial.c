@@ -20,7 +20,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include "_serial.h"
+#include "_serial_backend.h"
 #include "_serial_native.h"
+#include "_serial_trace.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -36,6 +39,8 @@ SOFTWARE.
 #define __DEFAULT_STOP_BITS    SERIAL_STOP_BITS_1
 #define __DEFAULT_PARITY       SERIAL_PARITY_NONE
 #define __DEFAULT_READ_TIMEOUT 0
+#define __DISCARD_CHUNK        4096
+#define __COPY_CHUNK           4096
 
 // Expected to be passed during compilation
 #ifndef LIB_VERSION
@@ -45,6 +50,8 @@ SOFTWARE.
 
 #define __SET_ERROR(err) errno = errno ? errno : err
 
+SERIAL_TRACE_DEFINE_SEMAPHORES()
+
 struct __serial_list {
 	size_t size;
 	char** elements;
@@ -52,49 +59,27 @@ struct __serial_list {
 };
 
 struct __serial {
-	void*              nativePort;
-	char*              portName;
-	serial_config_t    config;
-	uint32_t           readTimeout;
+	const _serial_backend_t* backend;
+	void*                    nativePort;
+	char*                    portName;
+	serial_config_t          config;
+	serial_rs485_config_t    rs485;
+	uint32_t                 readTimeout;
 };
 
 static void __serial_list_clear(serial_list_t* list) {
 	list->size = 0;
 }
 
+static int __serial_list_compare(const void* a, const void* b) {
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
 static void __serial_list_sort(serial_list_t* list) {
 	if (list->size <= 1)
 		return;
 
-	bool hasChanges;
-	char* current;
-	char* next;
-	char* buffer;
-	size_t i = 0;
-
-	do {
-		i = 0;
-		hasChanges = false;
-
-		current = list->elements[i];
-		next = i < (list->size - 1) ? list->elements[i + 1] : NULL;
-
-		while (next != NULL) {
-			if (strcmp(current, next) > 0) {
-				hasChanges = true;
-
-				buffer = list->elements[i];
-				list->elements[i] = list->elements[i + 1];
-				list->elements[i + 1] = buffer;
-
-				break;
-			}
-
-			i++;
-			current = next;
-			next = i < (list->size - 1) ? list->elements[i + 1] : NULL;
-		}
-	} while (hasChanges);
+	qsort(list->elements, list->size, sizeof(char*), __serial_list_compare);
 }
 
 const char* _serial_list_add(serial_list_t* list, const char* element) {
@@ -131,6 +116,15 @@ const char* _serial_list_add(serial_list_t* list, const char* element) {
 	return list->elements[list->size - 1];
 }
 
+int _serial_get_fd(const serial_t* port) {
+	if (!port->backend->get_fd) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	return port->backend->get_fd(port->nativePort);
+}
+
 SERIAL_PUBLIC const char* SERIAL_CALL serial_error_to_str(serial_error_e error) {
 	#define __err_to_str(e) #e
 	#define __err_case(e) case e: return __err_to_str(e)
@@ -142,6 +136,7 @@ SERIAL_PUBLIC const char* SERIAL_CALL serial_error_to_str(serial_error_e error)
 	__err_case(SERIAL_ERROR_NOT_FOUND);
 	__err_case(SERIAL_ERROR_INVALID_PARAM);
 	__err_case(SERIAL_ERROR_TIMEOUT);
+	__err_case(SERIAL_ERROR_NOT_SUPPORTED);
 
 	default:
 		return __err_to_str(SERIAL_ERROR_UNKNOWN);
@@ -194,8 +189,10 @@ error:
 SERIAL_PUBLIC serial_list_t* SERIAL_CALL serial_list_ports(serial_list_t* list) {
 	__serial_list_clear(list);
 
-	if (!_serial_native_list_ports(list))
-		goto error;
+	for (const _serial_backend_t* const* backend = _serial_backends(); *backend; backend++) {
+		if ((*backend)->list_ports && !(*backend)->list_ports(list))
+			goto error;
+	}
 
 	__serial_list_sort(list);
 	return list;
@@ -205,40 +202,57 @@ error:
 	return NULL;
 }
 
-SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open(const char* portName) {
+serial_t* _serial_new(const _serial_backend_t* backend, void* nativePort, const char* portName, const serial_config_t* config, uint32_t readTimeout) {
 	serial_t* port = malloc(sizeof(serial_t));
 
 	if (!port) {
 		errno = SERIAL_ERROR_MEM;
-		goto error;
+		return NULL;
 	}
 
-	port->nativePort = _serial_native_open(portName);
+	port->portName = malloc(strlen(portName) + 1);
 
-	if (!port->nativePort)
-		goto error;
+	if (!port->portName) {
+		free(port);
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
 
-	port->config.baud     = __DEFAULT_BAUD;
-	port->config.dataBits = __DEFAULT_DATA_BITS;
-	port->config.parity   = __DEFAULT_PARITY;
-	port->config.stopBits = __DEFAULT_STOP_BITS;
+	strcpy(port->portName, portName);
 
-	port->readTimeout = __DEFAULT_READ_TIMEOUT;
+	port->backend     = backend;
+	port->nativePort  = nativePort;
+	port->config      = *config;
+	port->readTimeout = readTimeout;
 
-	if (!_serial_native_config(port->nativePort, &port->config))
-		goto error;
+	memset(&port->rs485, 0, sizeof(serial_rs485_config_t)); // RS-485 mode is disabled by default
 
-	if (!_serial_native_set_read_timeout(port->nativePort, __DEFAULT_READ_TIMEOUT))
+	return port;
+}
+
+serial_t* _serial_open(const char* portName, uint32_t flags) {
+	serial_t* port;
+	const char* name;
+	const _serial_backend_t* backend = _serial_backend_find(portName, &name);
+	void* nativePort = backend->open(name, flags);
+
+	if (!nativePort)
 		goto error;
 
-	port->portName = malloc(strlen(portName) + 1);
+	serial_config_t config;
+	config.baud     = __DEFAULT_BAUD;
+	config.dataBits = __DEFAULT_DATA_BITS;
+	config.parity   = __DEFAULT_PARITY;
+	config.stopBits = __DEFAULT_STOP_BITS;
 
-	if (!port->portName) {
-		errno = SERIAL_ERROR_MEM;
+	if (!backend->config(nativePort, &config))
 		goto error;
-	}
 
-	strcpy(port->portName, portName);
+	if (!backend->set_read_timeout(nativePort, __DEFAULT_READ_TIMEOUT))
+		goto error;
+
+	if (!(port = _serial_new(backend, nativePort, portName, &config, __DEFAULT_READ_TIMEOUT)))
+		goto error;
 
 	return port;
 
@@ -246,16 +260,81 @@ error:
 	__SET_ERROR(SERIAL_ERROR_IO);
 	int currentError = errno;
 
-	if (port) {
-		if (port->nativePort != NULL) {
-			_serial_native_close(port->nativePort);
-		}
+	if (nativePort)
+		backend->close(nativePort);
 
-		free(port);
+	errno = currentError; // Discards any error that could happen during backend close()
+	return NULL;
+}
+
+const _serial_backend_t* _serial_get_backend(const serial_t* port) {
+	return port->backend;
+}
+
+void* _serial_get_native_port(const serial_t* port) {
+	return port->nativePort;
+}
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open(const char* portName) {
+	return _serial_open(portName, SERIAL_OPEN_FLAG_NONE);
+}
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_ex(const char* portName, uint32_t flags) {
+	return _serial_open(portName, flags);
+}
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_fd(int fd, uint32_t flags) {
+	char portName[16];
+
+	if (fd < 0) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return NULL;
 	}
 
-	errno = currentError; // Discards any error that could happen during _serial_native_close
-	return NULL;
+	snprintf(portName, sizeof(portName), "%s%d", _serial_fd_backend.scheme, fd);
+	return _serial_open(portName, flags);
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_create_virtual_pair(serial_t** a, serial_t** b, const char** nameA, const char** nameB) {
+	char slaveName[128];
+	int  masterFd;
+
+	if (!a || !b) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	*a = NULL;
+	*b = NULL;
+
+	if ((masterFd = _serial_native_open_pty(slaveName, sizeof(slaveName))) < 0)
+		goto error;
+
+	// NOTE: master end must be open before the slave one, and the slave one
+	//       shall be kept open while master is in use (otherwise reads on
+	//       master end fail).
+	if (!(*a = serial_open_fd(masterFd, SERIAL_OPEN_FLAG_NONE)))
+		goto error;
+
+	if (!(*b = serial_open(slaveName)))
+		goto error;
+
+	if (nameA) *nameA = serial_get_name(*a);
+	if (nameB) *nameB = serial_get_name(*b);
+
+	return true;
+
+error:
+	__SET_ERROR(SERIAL_ERROR_IO);
+	int currentError = errno;
+
+	if (*a) {
+		serial_close(*a);
+		*a = NULL;
+	}
+
+	errno = currentError; // Discards any error that could happen during serial_close()
+	return false;
 }
 
 SERIAL_PUBLIC const char* SERIAL_CALL serial_get_name(const serial_t* port) {
@@ -281,6 +360,8 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_config(serial_t* port, const serial_config
 	case SERIAL_PARITY_NONE:
 	case SERIAL_PARITY_EVEN:
 	case SERIAL_PARITY_ODD:
+	case SERIAL_PARITY_MARK:
+	case SERIAL_PARITY_SPACE:
 		break;
 
 	default:
@@ -298,12 +379,14 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_config(serial_t* port, const serial_config
 		return false;
 	}
 
-	if (!_serial_native_config(port->nativePort, config)) {
+	if (!port->backend->config(port->nativePort, config)) {
 		__SET_ERROR(SERIAL_ERROR_IO);
+		SERIAL_TRACE(config, port->portName, config->baud, config->dataBits, config->parity, config->stopBits, false);
 		return false;
 	}
 
 	port->config = *config;
+	SERIAL_TRACE(config, port->portName, config->baud, config->dataBits, config->parity, config->stopBits, true);
 	return true;
 }
 
@@ -311,11 +394,30 @@ SERIAL_PUBLIC void SERIAL_CALL serial_get_config(const serial_t* port, serial_co
 	*out = port->config;
 }
 
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_rs485(serial_t* port, const serial_rs485_config_t* config) {
+	if (!port->backend->set_rs485) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (!port->backend->set_rs485(port->nativePort, config)) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return false;
+	}
+
+	port->rs485 = *config;
+	return true;
+}
+
+SERIAL_PUBLIC void SERIAL_CALL serial_get_rs485(const serial_t* port, serial_rs485_config_t* out) {
+	*out = port->rs485;
+}
+
 SERIAL_PUBLIC bool SERIAL_CALL serial_set_read_timeout(serial_t* port, uint32_t millis) {
 	if (port->readTimeout == millis)
 		return true;
 
-	if (!_serial_native_set_read_timeout(port->nativePort, millis)) {
+	if (!port->backend->set_read_timeout(port->nativePort, millis)) {
 		__SET_ERROR(SERIAL_ERROR_IO);
 		return false;
 	}
@@ -329,7 +431,7 @@ SERIAL_PUBLIC uint32_t SERIAL_CALL serial_get_read_timeout(const serial_t* port)
 }
 
 SERIAL_PUBLIC bool SERIAL_CALL serial_purge(serial_t* port, serial_purge_type_e type) {
-	if (!_serial_native_purge(port->nativePort, type)) {
+	if (!port->backend->purge(port->nativePort, type)) {
 		__SET_ERROR(SERIAL_ERROR_IO);
 		return false;
 	}
@@ -341,7 +443,7 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_close(serial_t* port) {
 	if (
 		serial_set_read_timeout(port, 0)
 		&& serial_flush(port)
-		&& _serial_native_close(port->nativePort)
+		&& port->backend->close(port->nativePort)
 	) {
 		free(port->portName);
 		free(port);
@@ -353,12 +455,28 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_close(serial_t* port) {
 }
 
 SERIAL_PUBLIC int32_t SERIAL_CALL serial_available(const serial_t* port) {
-	return _serial_native_available(port->nativePort);
+	return port->backend->available(port->nativePort);
 }
 
-SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_t len) {
-	static uint8_t nullBuffer;
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_wait_readable(serial_t* port, uint32_t minBytes, uint32_t timeoutMillis) {
+	if (!port->backend->wait_readable) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int32_t available = port->backend->wait_readable(port->nativePort, minBytes, timeoutMillis);
+
+	if (available < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
 
+	return available;
+}
+
+// When errorMap is given, bits of bytes received with errors (and breaks on
+// breakMap, if given) are set on it
+static int32_t __serial_read(serial_t* port, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap) {
 	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
 
 	uint32_t remaining = len;
@@ -368,13 +486,16 @@ SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_
 
 	while (remaining > 0) {
 		errnoWasZero = errno == 0;
-		mRead = _serial_native_read(port->nativePort, (out ? out : &nullBuffer), (out ? remaining : 1));
+		if (errorMap) {
+			mRead = port->backend->read_marked(port->nativePort, out, remaining, errorMap, breakMap, (uint32_t)totalRead);
+		} else {
+			mRead = port->backend->read(port->nativePort, out, remaining);
+		}
 
 		if (mRead > 0) {
 			remaining -= mRead;
 			totalRead += mRead;
-			if (out)
-				out += mRead;
+			out += mRead;
 		} else { // mRead <= 0 (error or timeout)
 			if (totalRead > 0) {
 				// Ignore errors because some data was already read.
@@ -387,6 +508,7 @@ SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_
 					return -1;
 				} else { // Timeout
 					if (port->readTimeout > 0) {
+						SERIAL_TRACE(timeout, port->portName, port->readTimeout);
 						errno = SERIAL_ERROR_TIMEOUT;
 						return -1;
 					} else {
@@ -400,12 +522,44 @@ SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_
 	return totalRead;
 }
 
-SERIAL_PUBLIC bool SERIAL_CALL serial_write(serial_t* port, const void* in, uint32_t len) {
+// Same as __serial_read(), but discarding data (read in large chunks)
+static int32_t __serial_skip(serial_t* port, uint32_t len) {
+	uint8_t  scratch[__DISCARD_CHUNK];
+	int32_t  totalRead = 0;
+	int32_t  mRead;
+	int      previousError = errno;
+
+	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
+
+	while ((uint32_t)totalRead < len) {
+		uint32_t chunk = len - (uint32_t)totalRead;
+		chunk = chunk > sizeof(scratch) ? sizeof(scratch) : chunk;
+
+		mRead = __serial_read(port, scratch, chunk, NULL, NULL);
+
+		if (mRead <= 0) {
+			if (totalRead == 0)
+				return mRead;
+
+			errno = previousError; // Data was already read
+			break;
+		}
+
+		totalRead += mRead;
+
+		if ((uint32_t)mRead < chunk)
+			break; // Timeout
+	}
+
+	return totalRead;
+}
+
+static bool __serial_write(serial_t* port, const void* in, uint32_t len) {
 	uint32_t remaining = len;
 	int32_t  written;
 
 	while (remaining > 0) {
-		written = _serial_native_write(port->nativePort, in, remaining > INT32_MAX ? INT32_MAX : remaining);
+		written = port->backend->write(port->nativePort, in, remaining > INT32_MAX ? INT32_MAX : remaining);
 
 		// NOTE: function will return only when all data was written or an
 		//       error occurred (timeout on write is considered an error).
@@ -422,15 +576,364 @@ SERIAL_PUBLIC bool SERIAL_CALL serial_write(serial_t* port, const void* in, uint
 	return true;
 }
 
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_read(serial_t* port, void* out, uint32_t len) {
+	SERIAL_TRACE_START(read);
+	int32_t result = out ? __serial_read(port, out, len, NULL, NULL) : __serial_skip(port, len);
+	SERIAL_TRACE(read, port->portName, len, result, SERIAL_TRACE_ELAPSED(read));
+	return result;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_read_available(serial_t* port, void* out, uint32_t len) {
+	int32_t result;
+
+	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
+
+	SERIAL_TRACE_START(read);
+	if (port->backend->read_available) {
+		result = port->backend->read_available(port->nativePort, out, len);
+	} else {
+		// Reading no more than available data does not block
+		result = port->backend->available(port->nativePort);
+
+		if (result > 0)
+			result = port->backend->read(port->nativePort, out, (uint32_t)result < len ? (uint32_t)result : len);
+	}
+
+	if (result < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		result = -1;
+	}
+	SERIAL_TRACE(read, port->portName, len, result, SERIAL_TRACE_ELAPSED(read));
+
+	return result;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_splice_to_fd(serial_t* port, int fd, uint32_t len, uint32_t flags) {
+	uint8_t buffer[__COPY_CHUNK];
+	int     previousError = errno;
+	int32_t result;
+
+	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
+
+	if (port->backend->splice_to_fd) {
+		result = port->backend->splice_to_fd(port->nativePort, fd, len, flags);
+
+		if (result >= 0 || errno != SERIAL_ERROR_NOT_SUPPORTED)
+			goto done;
+
+		errno = previousError;
+	}
+
+	// Zero-copy transfer is not possible: data is copied through user space
+	len = len > sizeof(buffer) ? sizeof(buffer) : len;
+
+	if (flags & SERIAL_SPLICE_FLAG_NONBLOCK) {
+		result = serial_read_available(port, buffer, len);
+	} else {
+		result = port->backend->read(port->nativePort, buffer, len);
+	}
+
+	if (result > 0 && _serial_native_fd_write(fd, buffer, (uint32_t)result) < 0)
+		result = -1;
+
+done:
+	if (result < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	if (result == 0 && !(flags & SERIAL_SPLICE_FLAG_NONBLOCK) && port->readTimeout > 0) {
+		SERIAL_TRACE(timeout, port->portName, port->readTimeout);
+		errno = SERIAL_ERROR_TIMEOUT;
+		return -1;
+	}
+
+	return result;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_error_marking(serial_t* port, bool enabled) {
+	if (!port->backend->mark_errors) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (!port->backend->mark_errors(port->nativePort, enabled)) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return false;
+	}
+
+	return true;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_read_marked(serial_t* port, void* out, uint32_t len, uint8_t* errorMap, uint8_t* breakMap) {
+	if (!port->backend->read_marked) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	if (!out || !errorMap) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return -1;
+	}
+
+	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
+	memset(errorMap, 0, (len + 7) / 8);
+
+	if (breakMap)
+		memset(breakMap, 0, (len + 7) / 8);
+
+	SERIAL_TRACE_START(read);
+	int32_t result = __serial_read(port, out, len, errorMap, breakMap);
+	SERIAL_TRACE(read, port->portName, len, result, SERIAL_TRACE_ELAPSED(read));
+	return result;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_write(serial_t* port, const void* in, uint32_t len) {
+	SERIAL_TRACE_START(write);
+	bool result = __serial_write(port, in, len);
+	SERIAL_TRACE(write, port->portName, len, result, SERIAL_TRACE_ELAPSED(write));
+	return result;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_send_file(serial_t* port, int fd, uint64_t offset, uint32_t len) {
+	uint8_t buffer[__COPY_CHUNK];
+	int     previousError = errno;
+	int32_t sent = 0;
+
+	len = len > (uint32_t) INT32_MAX ? INT32_MAX : len;
+
+	if (port->backend->send_file) {
+		sent = port->backend->send_file(port->nativePort, fd, offset, len);
+
+		if (sent >= 0)
+			return sent;
+
+		if (errno != SERIAL_ERROR_NOT_SUPPORTED) {
+			__SET_ERROR(SERIAL_ERROR_IO);
+			return -1;
+		}
+
+		errno = previousError;
+		sent  = 0;
+	}
+
+	// Zero-copy transfer is not possible: data is copied through user space
+	while ((uint32_t)sent < len) {
+		uint32_t chunk = len - (uint32_t)sent;
+		chunk = chunk > sizeof(buffer) ? sizeof(buffer) : chunk;
+
+		int32_t mRead = _serial_native_fd_pread(fd, buffer, chunk, offset + (uint32_t)sent);
+
+		if (mRead < 0) {
+			__SET_ERROR(SERIAL_ERROR_IO);
+			return -1;
+		}
+
+		if (mRead == 0)
+			break; // End of file
+
+		if (!__serial_write(port, buffer, (uint32_t)mRead))
+			return -1;
+
+		sent += mRead;
+	}
+
+	return sent;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_write_address(serial_t* port, uint8_t address) {
+	if (!port->backend->write_address) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (port->config.parity != SERIAL_PARITY_MARK && port->config.parity != SERIAL_PARITY_SPACE) {
+		errno = SERIAL_ERROR_INVALID_PARAM; // 9th bit is carried by a stick parity bit
+		return false;
+	}
+
+	if (!port->backend->write_address(port->nativePort, address)) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return false;
+	}
+
+	return true;
+}
+
 SERIAL_PUBLIC bool SERIAL_CALL serial_flush(serial_t* port) {
-	bool result = _serial_native_flush(port->nativePort);
+	SERIAL_TRACE_START(flush);
+	bool result = port->backend->flush(port->nativePort);
 
 	if (!result)
 		__SET_ERROR(SERIAL_ERROR_IO);
 
+	SERIAL_TRACE(flush, port->portName, result, SERIAL_TRACE_ELAPSED(flush));
 	return result;
 }
 
+SERIAL_PUBLIC int SERIAL_CALL serial_flush_async(serial_t* port) {
+	if (!port->backend->flush_async) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int fd = port->backend->flush_async(port->nativePort);
+
+	if (fd < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	return fd;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_tx_pending(const serial_t* port) {
+	if (!port->backend->tx_pending) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int32_t pending = port->backend->tx_pending(port->nativePort);
+
+	if (pending < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	return pending;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_send_break(serial_t* port, uint32_t durationMicros) {
+	if (!port->backend->send_break) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (!port->backend->send_break(port->nativePort, durationMicros)) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return false;
+	}
+
+	return true;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_discard(serial_t* port, uint32_t maxBytes, uint32_t idleMillis) {
+	uint8_t  scratch[__DISCARD_CHUNK];
+	uint32_t limit     = (maxBytes == 0 || maxBytes > INT32_MAX) ? INT32_MAX : maxBytes;
+	uint32_t discarded = 0;
+	int32_t  mRead;
+	bool     result    = false;
+
+	if (idleMillis == 0) {
+		// Only data already buffered is dropped. It is read instead of purged,
+		// so data arriving meanwhile is neither lost nor miscounted.
+		int32_t available = port->backend->available(port->nativePort);
+
+		if (available < 0)
+			goto error;
+
+		if ((uint32_t)available > limit)
+			available = (int32_t)limit;
+
+		return available > 0 ? __serial_skip(port, (uint32_t)available) : 0;
+	}
+
+	// Incoming data is drained until line is idle for given time
+	if (!port->backend->set_read_timeout(port->nativePort, idleMillis))
+		goto error;
+
+	result = true;
+
+	while (discarded < limit) {
+		uint32_t len = limit - discarded;
+		len = len > sizeof(scratch) ? sizeof(scratch) : len;
+
+		mRead = port->backend->read(port->nativePort, scratch, len);
+
+		if (mRead < 0) {
+			result = false;
+			break;
+		}
+
+		if (mRead == 0)
+			break; // Idle
+
+		discarded += (uint32_t)mRead;
+	}
+
+	if (!port->backend->set_read_timeout(port->nativePort, port->readTimeout))
+		result = false;
+
+	if (result)
+		return (int32_t)discarded;
+
+error:
+	__SET_ERROR(SERIAL_ERROR_IO);
+	return -1;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_lines(serial_t* port, uint32_t mask, uint32_t values) {
+	if (!port->backend->set_lines) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return false;
+	}
+
+	if (!port->backend->set_lines(port->nativePort, mask, values)) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return false;
+	}
+
+	return true;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_get_lines(serial_t* port) {
+	if (!port->backend->get_lines) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int32_t lines = port->backend->get_lines(port->nativePort);
+
+	if (lines < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	return lines;
+}
+
+SERIAL_PUBLIC int32_t SERIAL_CALL serial_wait_lines(serial_t* port, uint32_t mask, uint32_t timeoutMillis) {
+	if (!port->backend->wait_lines) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int32_t lines = port->backend->wait_lines(port->nativePort, mask, timeoutMillis);
+
+	if (lines < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	return lines;
+}
+
+SERIAL_PUBLIC int SERIAL_CALL serial_get_lines_event_fd(serial_t* port) {
+	if (!port->backend->lines_event_fd) {
+		errno = SERIAL_ERROR_NOT_SUPPORTED;
+		return -1;
+	}
+
+	int fd = port->backend->lines_event_fd(port->nativePort);
+
+	if (fd < 0) {
+		__SET_ERROR(SERIAL_ERROR_IO);
+		return -1;
+	}
+
+	return fd;
+}
+
 SERIAL_PUBLIC const char* SERIAL_CALL serial_version() {
 	return LIB_VERSION;
 }
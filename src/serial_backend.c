@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "_serial_backend.h"
+#include "_serial_native.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+
+const _serial_backend_t _serial_native_backend = {
+	.scheme           = NULL,
+	.list_ports       = _serial_native_list_ports,
+	.open             = _serial_native_open,
+	.config           = _serial_native_config,
+	.set_read_timeout = _serial_native_set_read_timeout,
+	.set_rs485        = _serial_native_set_rs485,
+	.purge            = _serial_native_purge,
+	.close            = _serial_native_close,
+	.available        = _serial_native_available,
+	.wait_readable    = _serial_native_wait_readable,
+	.read             = _serial_native_read,
+	.read_available   = _serial_native_read_available,
+	.splice_to_fd     = _serial_native_splice_to_fd,
+	.write            = _serial_native_write,
+	.send_file        = _serial_native_send_file,
+	.mark_errors      = _serial_native_mark_errors,
+	.read_marked      = _serial_native_read_marked,
+	.flush            = _serial_native_flush,
+	.flush_async      = _serial_native_flush_async,
+	.tx_pending       = _serial_native_tx_pending,
+	.write_address    = _serial_native_write_address,
+	.send_break       = _serial_native_send_break,
+	.set_lines        = _serial_native_set_lines,
+	.get_lines        = _serial_native_get_lines,
+	.wait_lines       = _serial_native_wait_lines,
+	.lines_event_fd   = _serial_native_lines_event_fd,
+	.get_fd           = _serial_native_get_fd
+};
+
+static void* __fd_open(const char* name, uint32_t flags) {
+	char* end;
+	long fd = strtol(name, &end, 10);
+
+	if (*name == '\0' || *end != '\0' || fd < 0 || fd > INT_MAX) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return NULL;
+	}
+
+	return _serial_native_open_fd((int)fd, flags);
+}
+
+const _serial_backend_t _serial_fd_backend = {
+	.scheme           = "fd:",
+	.list_ports       = NULL,
+	.open             = __fd_open,
+	.config           = _serial_native_config,
+	.set_read_timeout = _serial_native_set_read_timeout,
+	.set_rs485        = _serial_native_set_rs485,
+	.purge            = _serial_native_purge,
+	.close            = _serial_native_close,
+	.available        = _serial_native_available,
+	.wait_readable    = _serial_native_wait_readable,
+	.read             = _serial_native_read,
+	.read_available   = _serial_native_read_available,
+	.splice_to_fd     = _serial_native_splice_to_fd,
+	.write            = _serial_native_write,
+	.send_file        = _serial_native_send_file,
+	.mark_errors      = _serial_native_mark_errors,
+	.read_marked      = _serial_native_read_marked,
+	.flush            = _serial_native_flush,
+	.flush_async      = _serial_native_flush_async,
+	.tx_pending       = _serial_native_tx_pending,
+	.write_address    = _serial_native_write_address,
+	.send_break       = _serial_native_send_break,
+	.set_lines        = _serial_native_set_lines,
+	.get_lines        = _serial_native_get_lines,
+	.wait_lines       = _serial_native_wait_lines,
+	.lines_event_fd   = _serial_native_lines_event_fd,
+	.get_fd           = _serial_native_get_fd
+};
+
+static const _serial_backend_t* const __backends[] = {
+	&_serial_fd_backend,
+	&_serial_mem_backend,
+	&_serial_null_backend,
+	&_serial_line_backend,
+	&_serial_fault_backend,
+	&_serial_broker_backend,
+	&_serial_pty_backend,
+	&_serial_native_backend,
+	NULL
+};
+
+const _serial_backend_t* const* _serial_backends() {
+	return __backends;
+}
+
+const _serial_backend_t* _serial_backend_find(const char* portName, const char** nameOut) {
+	const _serial_backend_t* const* backend;
+
+	for (backend = __backends; (*backend)->scheme; backend++) {
+		size_t schemeLen = strlen((*backend)->scheme);
+
+		if (strncmp(portName, (*backend)->scheme, schemeLen) == 0) {
+			*nameOut = portName + schemeLen;
+			return *backend;
+		}
+	}
+
+	*nameOut = portName;
+	return *backend; // Native backend
+}
@@ -0,0 +1,489 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "_serial_backend.h"
+#include "_serial_native.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define __CHUNK_SIZE 4096
+
+typedef struct __fault_buffer __fault_buffer_t;
+typedef struct __fault_port   __fault_port_t;
+
+struct __fault_buffer {
+	uint8_t* data;
+	uint32_t head;
+	uint32_t size;
+	uint32_t capacity;
+};
+
+/*
+ * Fault injection stacked on top of another port. Faults are applied to
+ * data flowing in the enabled directions, driven by a seedable PRNG (so a
+ * given seed and traffic always produce the same faults).
+*/
+struct __fault_port {
+	serial_t*             inner;
+	serial_fault_config_t config;
+	serial_fault_stats_t  stats;
+	uint64_t              prngState;
+	uint8_t               dataMask;       // Bits which can be flipped (depends on data bits)
+	uint32_t              burstRemaining; // Bytes still to be replaced by noise
+
+	// Thresholds (32-bit PRNG value below threshold means event happened)
+	uint64_t              bitThreshold;
+	uint64_t              dropThreshold;
+	uint64_t              duplicateThreshold;
+	uint64_t              burstThreshold;
+	uint64_t              stallThreshold;
+
+	__fault_buffer_t      rx; // Received data pending delivery
+	__fault_buffer_t      tx; // Scratch buffer for data being written
+};
+
+static uint32_t __random(__fault_port_t* port) {
+	// xorshift64*
+	uint64_t x = port->prngState;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	port->prngState = x;
+	return (uint32_t)((x * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static uint64_t __threshold(double probability) {
+	if (probability <= 0)
+		return 0;
+
+	if (probability >= 1)
+		return 1ull << 32;
+
+	return (uint64_t)(probability * 4294967296.0);
+}
+
+static bool __happens(__fault_port_t* port, uint64_t threshold) {
+	return threshold != 0 && __random(port) < threshold;
+}
+
+static void __apply_config(__fault_port_t* port, const serial_fault_config_t* config) {
+	port->config             = *config;
+	port->prngState          = config->seed ? config->seed : 0x9E3779B97F4A7C15ull;
+	port->burstRemaining     = 0;
+	port->bitThreshold       = __threshold(config->bitErrorRate);
+	port->dropThreshold      = __threshold(config->dropRate);
+	port->duplicateThreshold = __threshold(config->duplicateRate);
+	port->burstThreshold     = __threshold(config->burstRate);
+	port->stallThreshold     = __threshold(config->stallRate);
+}
+
+static void __set_data_mask(__fault_port_t* port, serial_data_bits_e dataBits) {
+	port->dataMask = (uint8_t)((1u << dataBits) - 1);
+}
+
+static bool __append(__fault_buffer_t* buffer, uint8_t b) {
+	if (buffer->head + buffer->size == buffer->capacity) {
+		if (buffer->head > 0) {
+			memmove(buffer->data, buffer->data + buffer->head, buffer->size);
+			buffer->head = 0;
+		} else {
+			uint32_t newCapacity = buffer->capacity == 0 ? __CHUNK_SIZE : buffer->capacity * 2;
+			uint8_t* newData = realloc(buffer->data, newCapacity);
+
+			if (!newData) {
+				errno = SERIAL_ERROR_MEM;
+				return false;
+			}
+
+			buffer->data     = newData;
+			buffer->capacity = newCapacity;
+		}
+	}
+
+	buffer->data[buffer->head + buffer->size] = b;
+	buffer->size++;
+	return true;
+}
+
+static bool __stall(__fault_port_t* port) {
+	if (!__happens(port, port->stallThreshold))
+		return false;
+
+	port->stats.stalls++;
+	_serial_native_sleep(port->config.stallMillis * 1000000ull);
+	return true;
+}
+
+// Appends given data (after fault injection) to given buffer
+static bool __inject(__fault_port_t* port, __fault_buffer_t* buffer, const uint8_t* data, uint32_t len) {
+	for (uint32_t i = 0; i < len; i++) {
+		uint8_t b = data[i];
+		port->stats.bytes++;
+
+		if (__happens(port, port->dropThreshold)) {
+			port->stats.drops++;
+			continue;
+		}
+
+		if (port->burstRemaining == 0 && __happens(port, port->burstThreshold)) {
+			port->stats.bursts++;
+			port->burstRemaining = port->config.burstLength;
+		}
+
+		if (port->burstRemaining > 0) {
+			port->burstRemaining--;
+			port->stats.burstBytes++;
+			b = (uint8_t)__random(port) & port->dataMask;
+		} else if (port->bitThreshold) {
+			for (uint8_t mask = 1; mask & port->dataMask; mask <<= 1) {
+				if (__happens(port, port->bitThreshold)) {
+					port->stats.bitErrors++;
+					b ^= mask;
+				}
+			}
+		}
+
+		if (!__append(buffer, b))
+			return false;
+
+		if (__happens(port, port->duplicateThreshold)) {
+			port->stats.duplicates++;
+
+			if (!__append(buffer, b))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+static __fault_port_t* __fault_port_new(serial_t* inner, const serial_fault_config_t* config) {
+	__fault_port_t* port = malloc(sizeof(__fault_port_t));
+
+	if (!port) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(port, 0, sizeof(__fault_port_t));
+
+	serial_config_t innerConfig;
+	serial_get_config(inner, &innerConfig);
+
+	port->inner = inner;
+	__set_data_mask(port, innerConfig.dataBits);
+	__apply_config(port, config);
+
+	return port;
+}
+
+static void* __fault_open(const char* name, uint32_t flags) {
+	static const serial_fault_config_t mNoFaults = { 0 };
+
+	serial_t* inner = _serial_open(name, flags);
+
+	if (!inner)
+		return NULL;
+
+	__fault_port_t* port = __fault_port_new(inner, &mNoFaults);
+
+	if (!port) {
+		int previousError = errno;
+		serial_close(inner);
+		errno = previousError;
+	}
+
+	return port;
+}
+
+static bool __fault_config(void* nativePort, const serial_config_t* config) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!serial_config(port->inner, config))
+		return false;
+
+	__set_data_mask(port, config->dataBits);
+	return true;
+}
+
+static bool __fault_set_read_timeout(void* nativePort, uint32_t millis) {
+	return serial_set_read_timeout(((__fault_port_t*)nativePort)->inner, millis);
+}
+
+static bool __fault_purge(void* nativePort, serial_purge_type_e type) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!serial_purge(port->inner, type))
+		return false;
+
+	if (type == SERIAL_PURGE_TYPE_RX || type == SERIAL_PURGE_TYPE_RX_TX) {
+		port->rx.head = 0;
+		port->rx.size = 0;
+	}
+
+	return true;
+}
+
+static bool __fault_close(void* nativePort) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!serial_close(port->inner))
+		return false;
+
+	free(port->rx.data);
+	free(port->tx.data);
+	free(port);
+	return true;
+}
+
+static int32_t __fault_available(const void* nativePort) {
+	const __fault_port_t* port = (const __fault_port_t*)nativePort;
+	int32_t available = serial_available(port->inner);
+
+	if (available < 0)
+		return -1;
+
+	return (uint32_t)available + port->rx.size > INT32_MAX ? INT32_MAX : available + (int32_t)port->rx.size;
+}
+
+static int32_t __fault_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (port->rx.size < minBytes && serial_wait_readable(port->inner, minBytes - port->rx.size, timeoutMillis) < 0)
+		return -1;
+
+	return __fault_available(nativePort);
+}
+
+// Reads data already available on inner port (waiting up to its read timeout for the first byte)
+static int32_t __inner_read(__fault_port_t* port, void* out, uint32_t len) {
+	int32_t available = serial_available(port->inner);
+
+	if (available < 0)
+		return -1;
+
+	if (available > 0 && (uint32_t)available < len)
+		len = (uint32_t)available;
+	else if (available == 0)
+		len = 1;
+
+	int32_t mRead = serial_read(port->inner, out, len);
+
+	// serial_read() reports timeouts as errors
+	return (mRead < 0 && errno == SERIAL_ERROR_TIMEOUT) ? 0 : mRead;
+}
+
+// Delivers data pending on rx buffer
+static int32_t __take(__fault_port_t* port, void* out, uint32_t len) {
+	uint32_t mRead = port->rx.size > len ? len : port->rx.size;
+	memcpy(out, port->rx.data + port->rx.head, mRead);
+	port->rx.head += mRead;
+	port->rx.size -= mRead;
+
+	if (port->rx.size == 0)
+		port->rx.head = 0;
+
+	return (int32_t)mRead;
+}
+
+static int32_t __fault_read(void* nativePort, void* out, uint32_t len) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!(port->config.directions & SERIAL_FAULT_DIRECTION_RX))
+		return __inner_read(port, out, len);
+
+	uint8_t chunk[__CHUNK_SIZE];
+
+	__stall(port);
+
+	while (port->rx.size == 0) {
+		int32_t mRead = __inner_read(port, chunk, len > sizeof(chunk) ? sizeof(chunk) : len);
+
+		if (mRead <= 0)
+			return mRead;
+
+		if (!__inject(port, &port->rx, chunk, (uint32_t)mRead))
+			return -1;
+	}
+
+	return __take(port, out, len);
+}
+
+static int32_t __fault_read_available(void* nativePort, void* out, uint32_t len) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!(port->config.directions & SERIAL_FAULT_DIRECTION_RX))
+		return serial_read_available(port->inner, out, len);
+
+	uint8_t chunk[__CHUNK_SIZE];
+
+	// Stalls are not emulated (call must not block)
+	if (port->rx.size == 0) {
+		int32_t mRead = serial_read_available(port->inner, chunk, len > sizeof(chunk) ? sizeof(chunk) : len);
+
+		if (mRead <= 0)
+			return mRead;
+
+		if (!__inject(port, &port->rx, chunk, (uint32_t)mRead))
+			return -1;
+	}
+
+	return __take(port, out, len);
+}
+
+static int32_t __fault_write(void* nativePort, const void* in, uint32_t len) {
+	__fault_port_t* port = (__fault_port_t*)nativePort;
+
+	if (!(port->config.directions & SERIAL_FAULT_DIRECTION_TX))
+		return serial_write(port->inner, in, len) ? (int32_t)len : -1;
+
+	len = len > __CHUNK_SIZE ? __CHUNK_SIZE : len;
+
+	__stall(port);
+
+	port->tx.size = 0;
+
+	if (!__inject(port, &port->tx, in, len))
+		return -1;
+
+	if (port->tx.size > 0 && !serial_write(port->inner, port->tx.data, port->tx.size))
+		return -1;
+
+	return (int32_t)len;
+}
+
+static bool __fault_flush(void* nativePort) {
+	return serial_flush(((__fault_port_t*)nativePort)->inner);
+}
+
+static bool __fault_set_rs485(void* nativePort, const serial_rs485_config_t* config) {
+	return serial_set_rs485(((__fault_port_t*)nativePort)->inner, config);
+}
+
+static int __fault_flush_async(void* nativePort) {
+	return serial_flush_async(((__fault_port_t*)nativePort)->inner);
+}
+
+static int32_t __fault_tx_pending(const void* nativePort) {
+	return serial_tx_pending(((const __fault_port_t*)nativePort)->inner);
+}
+
+static bool __fault_write_address(void* nativePort, uint8_t address) {
+	return serial_write_address(((__fault_port_t*)nativePort)->inner, address);
+}
+
+static bool __fault_send_break(void* nativePort, uint32_t durationMicros) {
+	return serial_send_break(((__fault_port_t*)nativePort)->inner, durationMicros);
+}
+
+static bool __fault_set_lines(void* nativePort, uint32_t mask, uint32_t values) {
+	return serial_set_lines(((__fault_port_t*)nativePort)->inner, mask, values);
+}
+
+static int32_t __fault_get_lines(void* nativePort) {
+	return serial_get_lines(((__fault_port_t*)nativePort)->inner);
+}
+
+static int32_t __fault_wait_lines(void* nativePort, uint32_t mask, uint32_t timeoutMillis) {
+	return serial_wait_lines(((__fault_port_t*)nativePort)->inner, mask, timeoutMillis);
+}
+
+static int __fault_lines_event_fd(void* nativePort) {
+	return serial_get_lines_event_fd(((__fault_port_t*)nativePort)->inner);
+}
+
+const _serial_backend_t _serial_fault_backend = {
+	.scheme           = "fault://",
+	.list_ports       = NULL,
+	.open             = __fault_open,
+	.config           = __fault_config,
+	.set_read_timeout = __fault_set_read_timeout,
+	.set_rs485        = __fault_set_rs485,
+	.purge            = __fault_purge,
+	.close            = __fault_close,
+	.available        = __fault_available,
+	.wait_readable    = __fault_wait_readable,
+	.read             = __fault_read,
+	.read_available   = __fault_read_available,
+	.write            = __fault_write,
+	.flush            = __fault_flush,
+	.flush_async      = __fault_flush_async,
+	.tx_pending       = __fault_tx_pending,
+	.write_address    = __fault_write_address,
+	.send_break       = __fault_send_break,
+	.set_lines        = __fault_set_lines,
+	.get_lines        = __fault_get_lines,
+	.wait_lines       = __fault_wait_lines,
+	.lines_event_fd   = __fault_lines_event_fd
+};
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_fault_injection(serial_t* port, const serial_fault_config_t* config) {
+	serial_config_t portConfig;
+	serial_get_config(port, &portConfig);
+
+	size_t szScheme = strlen(_serial_fault_backend.scheme);
+	char* portName = malloc(szScheme + strlen(serial_get_name(port)) + 1);
+
+	if (!portName) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	strcpy(portName, _serial_fault_backend.scheme);
+	strcpy(portName + szScheme, serial_get_name(port));
+
+	serial_t* faultPort = NULL;
+	__fault_port_t* nativePort = __fault_port_new(port, config);
+
+	if (nativePort) {
+		if (!(faultPort = _serial_new(&_serial_fault_backend, nativePort, portName, &portConfig, serial_get_read_timeout(port)))) {
+			int previousError = errno;
+			free(nativePort);
+			errno = previousError;
+		}
+	}
+
+	free(portName);
+	return faultPort;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_set_fault_config(serial_t* port, const serial_fault_config_t* config) {
+	if (_serial_get_backend(port) != &_serial_fault_backend) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	__apply_config(_serial_get_native_port(port), config);
+	return true;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_get_fault_stats(const serial_t* port, serial_fault_stats_t* out) {
+	if (_serial_get_backend(port) != &_serial_fault_backend) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	*out = ((const __fault_port_t*)_serial_get_native_port(port))->stats;
+	return true;
+}
@@ -0,0 +1,599 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "_serial_backend.h"
+#include "_serial_native.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define __DEFAULT_BUFFER_SIZE    4096
+#define __DEFAULT_RX_BUFFER_SIZE 4096
+#define __DEFAULT_LATENCY_MILLIS 0
+#define __IDLE_POLL_NANOS        1000000ull // Inner port polling period while there is nothing to deliver
+#define __NANOS_PER_MILLI        1000000ull
+
+typedef struct __line_segment __line_segment_t;
+
+typedef struct __line_port __line_port_t;
+
+/*
+ * Run of bytes received from inner port. Byte 'i' of a segment completes
+ * its transmission on the emulated line at 'start + (i + 1) * charNanos'.
+*/
+struct __line_segment {
+	uint64_t start;
+	uint32_t len;
+};
+
+/*
+ * Line-rate emulation stacked on top of another port:
+ *
+ * - TX: data is handed to inner port immediately, but the writer is
+ *   blocked whenever more than 'bufferSize' bytes would still be waiting
+ *   for transmission at the configured line rate (flush waits until the
+ *   emulated line is idle).
+ *
+ * - RX: bytes taken from inner port are released to the reader only after
+ *   their transmission would have completed on the line, rounded up to the
+ *   next latency timer tick. Bytes are timed from the moment they are seen
+ *   on inner port, so the receiving end is expected to be polled (read or
+ *   available) while data is in flight. Released bytes which do not fit
+ *   into 'rxBufferSize' are dropped, as received by a UART whose buffer is
+ *   full (overrun).
+*/
+struct __line_port {
+	serial_t*               inner;
+	serial_line_emulation_t emulation;
+	uint64_t                charNanos;
+	uint64_t                epoch;       // Reference for latency timer ticks
+	uint32_t                readTimeout;
+	uint64_t                txBusyUntil; // End of transmission of last queued byte
+	uint64_t                rxLineEnd;   // End of transmission of last received byte
+
+	uint8_t*                rxData;
+	uint32_t                rxHead;
+	uint32_t                rxSize;
+	uint32_t                rxCapacity;
+
+	__line_segment_t*       segments;
+	uint32_t                segHead;
+	uint32_t                segCount;
+	uint32_t                segCapacity;
+
+	serial_line_stats_t     stats;
+};
+
+static uint64_t __char_nanos(const serial_config_t* config) {
+	// Using half-bits due to 1.5 stop bits
+	uint64_t halfBits = 2 * (1 + config->dataBits + (config->parity == SERIAL_PARITY_NONE ? 0 : 1));
+
+	switch (config->stopBits) {
+	case SERIAL_STOP_BITS_1_5:
+		halfBits += 3;
+		break;
+
+	case SERIAL_STOP_BITS_2:
+		halfBits += 4;
+		break;
+
+	default:
+		halfBits += 2;
+		break;
+	}
+
+	return (halfBits * 1000000000ull) / (2ull * (config->baud ? config->baud : 1));
+}
+
+static bool __reserve(void** buffer, uint32_t* head, uint32_t size, uint32_t* capacity, uint32_t required, size_t itemSize) {
+	if (*head + size + required <= *capacity)
+		return true;
+
+	if (*head > 0) {
+		memmove(*buffer, (uint8_t*)*buffer + *head * itemSize, size * itemSize);
+		*head = 0;
+	}
+
+	if (size + required <= *capacity)
+		return true;
+
+	uint32_t newCapacity = *capacity == 0 ? 256 : *capacity;
+	while (newCapacity < size + required)
+		newCapacity *= 2;
+
+	void* newBuffer = realloc(*buffer, newCapacity * itemSize);
+	if (!newBuffer) {
+		errno = SERIAL_ERROR_MEM;
+		return false;
+	}
+
+	*buffer   = newBuffer;
+	*capacity = newCapacity;
+	return true;
+}
+
+static bool __pull(__line_port_t* port) {
+	int32_t available = serial_available(port->inner);
+
+	if (available <= 0)
+		return available == 0;
+
+	if (!__reserve((void**)&port->rxData, &port->rxHead, port->rxSize, &port->rxCapacity, available, 1))
+		return false;
+
+	int32_t mRead = serial_read(port->inner, port->rxData + port->rxHead + port->rxSize, available);
+
+	if (mRead <= 0)
+		return mRead == 0;
+
+	uint64_t now   = _serial_native_nanos();
+	uint64_t start = now > port->charNanos ? now - port->charNanos : 0;
+
+	if (start < port->rxLineEnd)
+		start = port->rxLineEnd; // Line is still busy with previous bytes
+
+	if (port->segCount > 0 && start == port->rxLineEnd) {
+		// Back-to-back with previous segment
+		port->segments[port->segHead + port->segCount - 1].len += mRead;
+	} else {
+		if (!__reserve((void**)&port->segments, &port->segHead, port->segCount, &port->segCapacity, 1, sizeof(__line_segment_t)))
+			return false;
+
+		__line_segment_t* segment = &port->segments[port->segHead + port->segCount];
+		segment->start = start;
+		segment->len   = mRead;
+		port->segCount++;
+	}
+
+	port->rxSize   += mRead;
+	port->rxLineEnd = start + mRead * port->charNanos;
+	return true;
+}
+
+static uint64_t __tick_floor(const __line_port_t* port, uint64_t timestamp) {
+	uint64_t latency = port->emulation.latencyMillis * __NANOS_PER_MILLI;
+
+	if (latency == 0 || timestamp < port->epoch)
+		return timestamp;
+
+	return port->epoch + ((timestamp - port->epoch) / latency) * latency;
+}
+
+static uint64_t __tick_ceil(const __line_port_t* port, uint64_t timestamp) {
+	uint64_t floor = __tick_floor(port, timestamp);
+	return floor == timestamp ? floor : floor + port->emulation.latencyMillis * __NANOS_PER_MILLI;
+}
+
+static uint32_t __releasable(const __line_port_t* port, uint64_t now) {
+	uint64_t horizon = __tick_floor(port, now);
+	uint32_t count = 0;
+
+	for (uint32_t i = port->segHead; i < port->segHead + port->segCount; i++) {
+		const __line_segment_t* segment = &port->segments[i];
+
+		if (horizon >= segment->start + segment->len * port->charNanos) {
+			count += segment->len;
+		} else {
+			if (horizon > segment->start)
+				count += (horizon - segment->start) / port->charNanos;
+
+			break;
+		}
+	}
+
+	return count;
+}
+
+static uint64_t __next_release(const __line_port_t* port) {
+	const __line_segment_t* segment = &port->segments[port->segHead];
+	return __tick_ceil(port, segment->start + port->charNanos);
+}
+
+static uint64_t __byte_release(const __line_port_t* port, uint32_t index) {
+	for (uint32_t i = port->segHead; i < port->segHead + port->segCount; i++) {
+		const __line_segment_t* segment = &port->segments[i];
+
+		if (index < segment->len)
+			return __tick_ceil(port, segment->start + (index + 1) * port->charNanos);
+
+		index -= segment->len;
+	}
+
+	return UINT64_MAX; // Not received yet
+}
+
+// Removes the timing of the first 'len' bytes
+static void __skip_segments(__line_port_t* port, uint32_t len) {
+	while (len > 0) {
+		__line_segment_t* segment = &port->segments[port->segHead];
+
+		if (segment->len <= len) {
+			len -= segment->len;
+			port->segHead++;
+			port->segCount--;
+		} else {
+			segment->start += len * port->charNanos;
+			segment->len   -= len;
+			len = 0;
+		}
+	}
+
+	if (port->segCount == 0)
+		port->segHead = 0;
+}
+
+static void __consume(__line_port_t* port, void* out, uint32_t len) {
+	memcpy(out, port->rxData + port->rxHead, len);
+	port->rxHead += len;
+	port->rxSize -= len;
+
+	if (port->rxSize == 0)
+		port->rxHead = 0;
+
+	__skip_segments(port, len);
+}
+
+// Nothing is consumed between two calls, so bytes released beyond receive
+// buffer size since last call were received while the buffer was full.
+static void __drop_overrun(__line_port_t* port, uint32_t releasable) {
+	uint32_t capacity = port->emulation.rxBufferSize;
+
+	if (capacity == 0 || releasable <= capacity)
+		return;
+
+	uint32_t excess = releasable - capacity;
+	uint8_t* kept   = port->rxData + port->rxHead + capacity;
+
+	memmove(kept, kept + excess, port->rxSize - releasable);
+	port->rxSize -= excess;
+
+	// Kept bytes take the timing of the last released ones (all released)
+	__skip_segments(port, excess);
+
+	port->stats.overruns += excess;
+}
+
+// Pulls data from inner port and returns the number of bytes released to the reader
+static int32_t __update(__line_port_t* port, uint64_t now) {
+	if (!__pull(port))
+		return -1;
+
+	uint32_t releasable = __releasable(port, now);
+	__drop_overrun(port, releasable);
+
+	uint32_t capacity = port->emulation.rxBufferSize;
+	return (int32_t)(capacity > 0 && releasable > capacity ? capacity : releasable);
+}
+
+static void __sleep_until(uint64_t timestamp) {
+	uint64_t now = _serial_native_nanos();
+
+	if (timestamp > now)
+		_serial_native_sleep(timestamp - now);
+}
+
+static __line_port_t* __line_port_new(serial_t* inner, const serial_line_emulation_t* emulation) {
+	__line_port_t* port = malloc(sizeof(__line_port_t));
+
+	if (!port) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(port, 0, sizeof(__line_port_t));
+
+	// Inner port is polled (timeouts are handled by the emulation)
+	if (!serial_set_read_timeout(inner, 0)) {
+		free(port);
+		return NULL;
+	}
+
+	serial_config_t config;
+	serial_get_config(inner, &config);
+
+	port->inner     = inner;
+	port->emulation = *emulation;
+	port->charNanos = __char_nanos(&config);
+	port->epoch     = _serial_native_nanos();
+
+	return port;
+}
+
+static void* __line_open(const char* name, uint32_t flags) {
+	static const serial_line_emulation_t mDefaultEmulation = {
+		.bufferSize    = __DEFAULT_BUFFER_SIZE,
+		.latencyMillis = __DEFAULT_LATENCY_MILLIS,
+		.rxBufferSize  = __DEFAULT_RX_BUFFER_SIZE
+	};
+
+	serial_t* inner = _serial_open(name, flags);
+
+	if (!inner)
+		return NULL;
+
+	__line_port_t* port = __line_port_new(inner, &mDefaultEmulation);
+
+	if (!port) {
+		int previousError = errno;
+		serial_close(inner);
+		errno = previousError;
+	}
+
+	return port;
+}
+
+static bool __line_config(void* nativePort, const serial_config_t* config) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	if (!serial_config(port->inner, config))
+		return false;
+
+	port->charNanos = __char_nanos(config);
+	return true;
+}
+
+static bool __line_set_read_timeout(void* nativePort, uint32_t millis) {
+	((__line_port_t*)nativePort)->readTimeout = millis;
+	return true;
+}
+
+static bool __line_purge(void* nativePort, serial_purge_type_e type) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	if (!serial_purge(port->inner, type))
+		return false;
+
+	if (type == SERIAL_PURGE_TYPE_RX || type == SERIAL_PURGE_TYPE_RX_TX) {
+		port->rxHead   = 0;
+		port->rxSize   = 0;
+		port->segHead  = 0;
+		port->segCount = 0;
+	}
+
+	if (type == SERIAL_PURGE_TYPE_TX || type == SERIAL_PURGE_TYPE_RX_TX)
+		port->txBusyUntil = 0;
+
+	return true;
+}
+
+static bool __line_close(void* nativePort) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	if (!serial_close(port->inner))
+		return false;
+
+	free(port->rxData);
+	free(port->segments);
+	free(port);
+	return true;
+}
+
+static int32_t __line_available(const void* nativePort) {
+	return __update((__line_port_t*)nativePort, _serial_native_nanos());
+}
+
+static int32_t __line_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	uint64_t now = _serial_native_nanos();
+	uint64_t deadline = timeoutMillis == UINT32_MAX ? UINT64_MAX : now + timeoutMillis * __NANOS_PER_MILLI;
+
+	if (port->emulation.rxBufferSize > 0 && minBytes > port->emulation.rxBufferSize) {
+		errno = SERIAL_ERROR_INVALID_PARAM; // Would never fit into receive buffer
+		return -1;
+	}
+
+	while (true) {
+		int32_t releasable = __update(port, now);
+
+		if (releasable < 0 || (uint32_t)releasable >= minBytes)
+			return releasable;
+
+		if (now >= deadline) {
+			errno = SERIAL_ERROR_TIMEOUT;
+			return -1;
+		}
+
+		// Bytes not seen on inner port yet are timed when pulled
+		uint64_t wakeUp = port->rxSize >= minBytes ? __byte_release(port, minBytes - 1) : now + __IDLE_POLL_NANOS;
+		__sleep_until(wakeUp > deadline ? deadline : wakeUp);
+		now = _serial_native_nanos();
+	}
+}
+
+static int32_t __line_read(void* nativePort, void* out, uint32_t len) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	uint64_t now = _serial_native_nanos();
+	uint64_t deadline = now + port->readTimeout * __NANOS_PER_MILLI;
+
+	while (true) {
+		now = _serial_native_nanos();
+		int32_t releasable = __update(port, now);
+
+		if (releasable < 0)
+			return -1;
+
+		if (releasable > 0) {
+			releasable = (uint32_t)releasable > len ? (int32_t)len : releasable;
+			__consume(port, out, (uint32_t)releasable);
+			return releasable;
+		}
+
+		if (now >= deadline)
+			return 0; // Timeout
+
+		uint64_t wakeUp = port->rxSize > 0 ? __next_release(port) : now + __IDLE_POLL_NANOS;
+		__sleep_until(wakeUp > deadline ? deadline : wakeUp);
+	}
+}
+
+static int32_t __line_read_available(void* nativePort, void* out, uint32_t len) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+	int32_t releasable = __update(port, _serial_native_nanos());
+
+	if (releasable <= 0)
+		return releasable;
+
+	releasable = (uint32_t)releasable > len ? (int32_t)len : releasable;
+	__consume(port, out, (uint32_t)releasable);
+	return releasable;
+}
+
+static int32_t __line_write(void* nativePort, const void* in, uint32_t len) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	uint32_t bufferSize = port->emulation.bufferSize;
+	uint64_t now;
+	uint64_t queued;
+
+	while (true) {
+		now = _serial_native_nanos();
+
+		if (port->txBusyUntil < now)
+			port->txBusyUntil = now;
+
+		queued = (port->txBusyUntil - now + port->charNanos - 1) / port->charNanos;
+
+		if (bufferSize == 0 || queued < bufferSize)
+			break;
+
+		// Transmit buffer is full: wait for room
+		_serial_native_sleep((queued - bufferSize + 1) * port->charNanos);
+	}
+
+	if (bufferSize > 0 && len > bufferSize - queued)
+		len = bufferSize - (uint32_t)queued;
+
+	if (!serial_write(port->inner, in, len))
+		return -1;
+
+	port->txBusyUntil += len * port->charNanos;
+
+	if (bufferSize == 0)
+		__sleep_until(port->txBusyUntil); // Unbuffered: returns when data is on the wire
+
+	return (int32_t)len;
+}
+
+static bool __line_flush(void* nativePort) {
+	__line_port_t* port = (__line_port_t*)nativePort;
+
+	__sleep_until(port->txBusyUntil);
+	return serial_flush(port->inner);
+}
+
+static bool __line_set_rs485(void* nativePort, const serial_rs485_config_t* config) {
+	return serial_set_rs485(((__line_port_t*)nativePort)->inner, config);
+}
+
+static bool __line_write_address(void* nativePort, uint8_t address) {
+	return serial_write_address(((__line_port_t*)nativePort)->inner, address);
+}
+
+static bool __line_send_break(void* nativePort, uint32_t durationMicros) {
+	return serial_send_break(((__line_port_t*)nativePort)->inner, durationMicros);
+}
+
+static bool __line_set_lines(void* nativePort, uint32_t mask, uint32_t values) {
+	return serial_set_lines(((__line_port_t*)nativePort)->inner, mask, values);
+}
+
+static int32_t __line_get_lines(void* nativePort) {
+	return serial_get_lines(((__line_port_t*)nativePort)->inner);
+}
+
+static int32_t __line_wait_lines(void* nativePort, uint32_t mask, uint32_t timeoutMillis) {
+	return serial_wait_lines(((__line_port_t*)nativePort)->inner, mask, timeoutMillis);
+}
+
+static int __line_lines_event_fd(void* nativePort) {
+	return serial_get_lines_event_fd(((__line_port_t*)nativePort)->inner);
+}
+
+const _serial_backend_t _serial_line_backend = {
+	.scheme           = "line://",
+	.list_ports       = NULL,
+	.open             = __line_open,
+	.config           = __line_config,
+	.set_read_timeout = __line_set_read_timeout,
+	.set_rs485        = __line_set_rs485,
+	.purge            = __line_purge,
+	.close            = __line_close,
+	.available        = __line_available,
+	.wait_readable    = __line_wait_readable,
+	.read             = __line_read,
+	.read_available   = __line_read_available,
+	.write            = __line_write,
+	.flush            = __line_flush,
+	.write_address    = __line_write_address,
+	.send_break       = __line_send_break,
+	.set_lines        = __line_set_lines,
+	.get_lines        = __line_get_lines,
+	.wait_lines       = __line_wait_lines,
+	.lines_event_fd   = __line_lines_event_fd
+};
+
+SERIAL_PUBLIC serial_t* SERIAL_CALL serial_open_line_emulation(serial_t* port, const serial_line_emulation_t* emulation) {
+	uint32_t readTimeout = serial_get_read_timeout(port);
+	serial_config_t config;
+	serial_get_config(port, &config);
+
+	size_t szScheme = strlen(_serial_line_backend.scheme);
+	char* portName = malloc(szScheme + strlen(serial_get_name(port)) + 1);
+
+	if (!portName) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	strcpy(portName, _serial_line_backend.scheme);
+	strcpy(portName + szScheme, serial_get_name(port));
+
+	serial_t* linePort = NULL;
+	__line_port_t* nativePort = __line_port_new(port, emulation);
+
+	if (nativePort) {
+		nativePort->readTimeout = readTimeout;
+
+		if (!(linePort = _serial_new(&_serial_line_backend, nativePort, portName, &config, readTimeout))) {
+			int previousError = errno;
+			serial_set_read_timeout(port, readTimeout);
+			free(nativePort);
+			errno = previousError;
+		}
+	}
+
+	free(portName);
+	return linePort;
+}
+
+SERIAL_PUBLIC bool SERIAL_CALL serial_get_line_stats(const serial_t* port, serial_line_stats_t* out) {
+	if (_serial_get_backend(port) != &_serial_line_backend) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	*out = ((const __line_port_t*)_serial_get_native_port(port))->stats;
+	return true;
+}
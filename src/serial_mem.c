@@ -0,0 +1,197 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "_serial_backend.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#define __MIN_CAPACITY 256
+
+typedef struct __mem_port __mem_port_t;
+
+/*
+ * Loopback port: every written byte becomes available for read on the
+ * same port. Data is kept in a growable ring buffer, so operations never
+ * block and a read on an empty port times out immediately (nothing else
+ * could ever feed the port).
+*/
+struct __mem_port {
+	uint8_t* buffer;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t size;
+};
+
+static bool __grow(__mem_port_t* port, uint32_t required) {
+	if (required > (uint32_t)INT32_MAX) {
+		errno = SERIAL_ERROR_MEM;
+		return false;
+	}
+
+	uint32_t newCapacity = port->capacity == 0 ? __MIN_CAPACITY : port->capacity;
+	while (newCapacity < required)
+		newCapacity *= 2;
+
+	uint8_t* newBuffer = malloc(newCapacity);
+	if (!newBuffer) {
+		errno = SERIAL_ERROR_MEM;
+		return false;
+	}
+
+	// Linearizes current content
+	uint32_t firstPart = port->capacity - port->head;
+	firstPart = firstPart > port->size ? port->size : firstPart;
+
+	if (port->size > 0) {
+		memcpy(newBuffer, port->buffer + port->head, firstPart);
+		memcpy(newBuffer + firstPart, port->buffer, port->size - firstPart);
+	}
+
+	free(port->buffer);
+	port->buffer   = newBuffer;
+	port->capacity = newCapacity;
+	port->head     = 0;
+
+	return true;
+}
+
+static void* __mem_open(const char* name, uint32_t flags) {
+	__mem_port_t* port = malloc(sizeof(__mem_port_t));
+
+	if (!port) {
+		errno = SERIAL_ERROR_MEM;
+		return NULL;
+	}
+
+	memset(port, 0, sizeof(__mem_port_t));
+	return port;
+}
+
+static bool __mem_config(void* nativePort, const serial_config_t* config) {
+	return true;
+}
+
+static bool __mem_set_read_timeout(void* nativePort, uint32_t millis) {
+	return true;
+}
+
+static bool __mem_purge(void* nativePort, serial_purge_type_e type) {
+	__mem_port_t* port = (__mem_port_t*)nativePort;
+
+	switch (type) {
+	case SERIAL_PURGE_TYPE_RX:
+	case SERIAL_PURGE_TYPE_RX_TX:
+		port->head = 0;
+		port->size = 0;
+		break;
+
+	case SERIAL_PURGE_TYPE_TX:
+		break;
+
+	default:
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	return true;
+}
+
+static bool __mem_close(void* nativePort) {
+	__mem_port_t* port = (__mem_port_t*)nativePort;
+
+	free(port->buffer);
+	free(port);
+	return true;
+}
+
+static int32_t __mem_available(const void* nativePort) {
+	return (int32_t)((const __mem_port_t*)nativePort)->size;
+}
+
+static int32_t __mem_wait_readable(void* nativePort, uint32_t minBytes, uint32_t timeoutMillis) {
+	int32_t available = __mem_available(nativePort);
+
+	// Nothing else could ever feed the port
+	if ((uint32_t)available < minBytes) {
+		errno = SERIAL_ERROR_TIMEOUT;
+		return -1;
+	}
+
+	return available;
+}
+
+static int32_t __mem_read(void* nativePort, void* out, uint32_t len) {
+	__mem_port_t* port = (__mem_port_t*)nativePort;
+
+	uint32_t mRead = len > port->size ? port->size : len;
+	uint32_t firstPart = port->capacity - port->head;
+	firstPart = firstPart > mRead ? mRead : firstPart;
+
+	memcpy(out, port->buffer + port->head, firstPart);
+	memcpy((uint8_t*)out + firstPart, port->buffer, mRead - firstPart);
+
+	port->head = port->capacity == 0 ? 0 : (port->head + mRead) % port->capacity;
+	port->size -= mRead;
+
+	return (int32_t)mRead;
+}
+
+static int32_t __mem_write(void* nativePort, const void* in, uint32_t len) {
+	__mem_port_t* port = (__mem_port_t*)nativePort;
+
+	if (len == 0)
+		return 0;
+
+	if (port->size + len > port->capacity && !__grow(port, port->size + len))
+		return -1;
+
+	uint32_t tail = (port->head + port->size) % port->capacity;
+	uint32_t firstPart = port->capacity - tail;
+	firstPart = firstPart > len ? len : firstPart;
+
+	memcpy(port->buffer + tail, in, firstPart);
+	memcpy(port->buffer, (const uint8_t*)in + firstPart, len - firstPart);
+
+	port->size += len;
+	return (int32_t)len;
+}
+
+static bool __mem_flush(void* nativePort) {
+	return true;
+}
+
+const _serial_backend_t _serial_mem_backend = {
+	.scheme           = "mem://",
+	.list_ports       = NULL,
+	.open             = __mem_open,
+	.config           = __mem_config,
+	.set_read_timeout = __mem_set_read_timeout,
+	.purge            = __mem_purge,
+	.close            = __mem_close,
+	.available        = __mem_available,
+	.wait_readable    = __mem_wait_readable,
+	.read             = __mem_read,
+	.write            = __mem_write,
+	.flush            = __mem_flush
+};
@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "_serial_backend.h"
+
+#include <string.h>
+#include <errno.h>
+
+#define __EMPTY_NAME "empty"
+
+typedef struct __null_port __null_port_t;
+
+/*
+ * Mock port which completes operations instantly without touching the
+ * kernel: writes are discarded and reads return zeroed data (or time out
+ * immediately for "null://empty"). It holds no state, so measurements on
+ * top of it reflect library-side costs only.
+*/
+struct __null_port {
+	bool empty; // Reads never return data
+};
+
+static __null_port_t __source = { .empty = false };
+static __null_port_t __empty  = { .empty = true };
+
+static void* __null_open(const char* name, uint32_t flags) {
+	if (*name == '\0')
+		return &__source;
+
+	if (strcmp(name, __EMPTY_NAME) == 0)
+		return &__empty;
+
+	errno = SERIAL_ERROR_NOT_FOUND;
+	return NULL;
+}
+
+static bool __null_config(void* nativePort, const serial_config_t* config) {
+	return true;
+}
+
+static bool __null_set_read_timeout(void* nativePort, uint32_t millis) {
+	return true;
+}
+
+static bool __null_purge(void* nativePort, serial_purge_type_e type) {
+	switch (type) {
+	case SERIAL_PURGE_TYPE_RX:
+	case SERIAL_PURGE_TYPE_TX:
+	case SERIAL_PURGE_TYPE_RX_TX:
+		return true;
+
+	default:
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+}
+
+static bool __null_close(void* nativePort) {
+	return true;
+}
+
+static int32_t __null_available(const void* nativePort) {
+	return ((const __null_port_t*)nativePort)->empty ? 0 : INT32_MAX;
+}
+
+static int32_t __null_read(void* nativePort, void* out, uint32_t len) {
+	if (((__null_port_t*)nativePort)->empty)
+		return 0;
+
+	memset(out, 0, len);
+	return (int32_t)len;
+}
+
+static int32_t __null_write(void* nativePort, const void* in, uint32_t len) {
+	return (int32_t)len;
+}
+
+static bool __null_flush(void* nativePort) {
+	return true;
+}
+
+const _serial_backend_t _serial_null_backend = {
+	.scheme           = "null://",
+	.list_ports       = NULL,
+	.open             = __null_open,
+	.config           = __null_config,
+	.set_read_timeout = __null_set_read_timeout,
+	.purge            = __null_purge,
+	.close            = __null_close,
+	.available        = __null_available,
+	.read             = __null_read,
+	.write            = __null_write,
+	.flush            = __null_flush
+};
@@ -21,6 +21,9 @@ SOFTWARE.
 */
 
 #include "connection.h"
+#include "connection/msg.h"
+#include "connection/pkt.h"
+#include "timer.h"
 
 #include <serial.h>
 #include <comm.h>
@@ -34,6 +37,8 @@ SOFTWARE.
 #define __READ_TIMEOUT   3000
 #define __DEFAULT_BAUD   9600
 #define __DEFAULT_CONFIG CONNECTION_CONFIG_8N1
+#define __SYNC_TIMEOUT   250
+#define __SYNC_ATTEMPTS  12
 
 struct __connection {
 	serial_t*             port;
@@ -86,35 +91,13 @@ static int __convert_comm_error(int commError) {
 	}
 }
 
-static bool __purge(serial_t* port, uint32_t timeout) {
-	if (!port) {
-		errno = SERIAL_ERROR_IO;
-		return false;
-	}
-
-	uint32_t previousTimeout = serial_get_read_timeout(port);
-
-	if (!serial_set_read_timeout(port, timeout))
-		return false;
-
-	int previousError = errno;
-	errno = SERIAL_ERROR_OK;
-
-	// Discards all data until timeout (silence)
-	int32_t mRead;
-	while ((mRead = serial_read(port, NULL, 1)) >= 0);
-
-	bool result;
-	if (mRead < 0 && errno == SERIAL_ERROR_TIMEOUT) {
-		errno = previousError;
-		result = true;
-	} else {
-		result = false;
-	}
-
-	result = serial_set_read_timeout(port, previousTimeout) && result;
+static uint32_t __nonce() {
+	static uint32_t counter = 0;
 
-	return result;
+	// Each sync attempt must use a marker which cannot be mistaken for a
+	// stale reply to a previous attempt (or to a previous session).
+	counter++;
+	return (uint32_t)timer_nanos() ^ (counter * 0x9E3779B9u);
 }
 
 static bool __serial_config(serial_t* port, uint32_t baud, connection_config_e config) {
@@ -159,7 +142,8 @@ static bool __serial_config(serial_t* port, uint32_t baud, connection_config_e c
 	}
 
 	if (memcmp(&newConf, &oldConf, sizeof(serial_config_t))) {
-		return serial_config(port, &newConf) && __purge(port, __READ_TIMEOUT);
+		// Data received with previous configuration is meaningless
+		return serial_config(port, &newConf) && serial_discard(port, 0, 0) >= 0;
 	}
 
 	return true;
@@ -187,7 +171,8 @@ connection_t* connection_open(const char* portName) {
 		memset(connection, 0, sizeof(connection_t));
 	}
 
-	connection->port = serial_open(portName);
+	// Reconnecting to a running board must not reset it
+	connection->port = serial_open_ex(portName, SERIAL_OPEN_FLAG_NO_RESET);
 	if (!connection->port) {
 		goto error;
 	}
@@ -218,7 +203,10 @@ connection_t* connection_open(const char* portName) {
 		goto error;
 	}
 
-	if (!__purge(connection->port, __READ_TIMEOUT))
+	if (serial_discard(connection->port, 0, 0) < 0)
+		goto error;
+
+	if (!connection_sync(connection, CONNECTION_MODE_MESSAGE))
 		goto error;
 
 	#if DEBUG_ENABLED
@@ -259,6 +247,45 @@ bool connection_config(connection_t* connection, uint32_t baud, connection_confi
 	return __serial_config(connection->port, baud, config);
 }
 
+bool connection_sync(connection_t* connection, connection_mode_e mode) {
+	uint32_t readTimeout = serial_get_read_timeout(connection->port);
+	bool synced = false;
+
+	// A lost marker (e.g. sent while the remote end was still switching
+	// protocol) is recovered by a new attempt with a new marker.
+	if (!serial_set_read_timeout(connection->port, __SYNC_TIMEOUT))
+		return false;
+
+	for (int i = 0; !synced && i < __SYNC_ATTEMPTS; i++) {
+		uint32_t nonce = __nonce();
+
+		switch (mode) {
+		case CONNECTION_MODE_MESSAGE:
+			synced = connection_msg_sync(connection, nonce);
+			break;
+
+		case CONNECTION_MODE_PACKET:
+			synced = connection_pkt_sync(connection, nonce);
+			break;
+
+		default:
+			serial_set_read_timeout(connection->port, readTimeout);
+			errno = SERIAL_ERROR_INVALID_PARAM;
+			return false;
+		}
+	}
+
+	if (!serial_set_read_timeout(connection->port, readTimeout))
+		return false;
+
+	if (!synced) {
+		errno = SERIAL_ERROR_TIMEOUT;
+		return false;
+	}
+
+	return true;
+}
+
 bool connection_close(connection_t* connection) {
 	if (serial_close(connection->port)) {
 		comm_obj_del(connection->serialStream);
@@ -23,6 +23,7 @@ SOFTWARE.
 #pragma once
 
 #include "connection/config.h"
+#include "connection/mode.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -34,6 +35,8 @@ connection_t* connection_open(const char* portName);
 
 bool connection_config(connection_t* connection, uint32_t baud, connection_config_e config);
 
+bool connection_sync(connection_t* connection, connection_mode_e mode);
+
 bool connection_close(connection_t* connection);
 
 char* connection_read_msg(connection_t* connection);
@@ -31,6 +31,7 @@ SOFTWARE.
 #define __MSG_MAX_LEN       128
 #define __MSG_PING         "PING"
 #define __MSG_PROT         "PROT"
+#define __MSG_SYNC         "SYNC"
 #define __MSG_ACK          "ACK"
 #define __MSG_NAK          "NAK"
 #define __DEBUG_MSG_PREFIX "\033[90m"
@@ -47,6 +48,13 @@ static bool __startsWith(const char* str, const char* prefix) {
 	return true;
 }
 
+static bool __endsWith(const char* str, const char* suffix) {
+	size_t strLen    = strlen(str);
+	size_t suffixLen = strlen(suffix);
+
+	return strLen >= suffixLen && strcmp(str + strLen - suffixLen, suffix) == 0;
+}
+
 static const char* __read_message(connection_t* connection) {
 	while (true) {
 		const char* msg = connection_read_msg(connection);
@@ -101,5 +109,31 @@ bool connection_msg_protocol(connection_t* connection, uint32_t baud, connection
 		return false;
 	}
 
-	return connection_config(connection, baud, cfg);
+	return connection_config(connection, baud, cfg) && connection_sync(connection, mode);
+}
+
+bool connection_msg_sync(connection_t* connection, uint32_t nonce) {
+	char marker[9]; // 8 hex digits + '\0'
+	char msg[__MSG_MAX_LEN + 1]; // __MSG_MAX_LEN + '\0'
+	const char* rsp;
+
+	snprintf(marker, sizeof(marker), "%08" PRIx32, nonce);
+	snprintf(msg, sizeof(msg), "%s;%s", __MSG_SYNC, marker);
+
+	// An empty line terminates any partial (stale) line held by remote end
+	if (!connection_write_msg(connection, "")) return false;
+	if (!connection_write_msg(connection, msg)) return false;
+
+	// Everything before the echoed marker is stale. A partial line held by
+	// local stream is prepended to the echo, hence the suffix comparison.
+	while (true) {
+		rsp = __read_message(connection);
+		if (!rsp) {
+			errno = SERIAL_ERROR_TIMEOUT;
+			return false;
+		}
+
+		if (__endsWith(rsp, marker))
+			return true;
+	}
 }
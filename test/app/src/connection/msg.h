@@ -27,3 +27,5 @@ SOFTWARE.
 bool connection_msg_ping(connection_t* connection, const char* msg);
 
 bool connection_msg_protocol(connection_t* connection, uint32_t baud, connection_config_e cfg, connection_mode_e mode);
+
+bool connection_msg_sync(connection_t* connection, uint32_t nonce);
@@ -29,6 +29,7 @@ SOFTWARE.
 #define __PACKET_PING 2
 #define __PACKET_PROT 3
 #define __PACKET_DBG  4
+#define __PACKET_SYNC 5
 
 static uint8_t __buf[255];
 
@@ -130,5 +131,30 @@ bool connection_pkt_protocol(connection_t* connection, uint32_t baud, connection
 		return false;
 	}
 
-	return connection_config(connection, baud, cfg);
+	return connection_config(connection, baud, cfg) && connection_sync(connection, mode);
+}
+
+bool connection_pkt_sync(connection_t* connection, uint32_t nonce) {
+	uint8_t* buf = __buf;
+
+	*buf = __PACKET_SYNC;
+	buf++;
+
+	*((uint32_t*)buf) = nonce;
+	buf += sizeof(uint32_t);
+
+	if (!connection_write_packet(connection, __buf, buf - __buf)) return false;
+
+	// Everything before the echoed packet is stale
+	while (true) {
+		uint8_t rspLen;
+		uint8_t* rsp = __read_packet(connection, &rspLen);
+		if (!rsp) {
+			errno = SERIAL_ERROR_TIMEOUT;
+			return false;
+		}
+
+		if (rspLen == buf - __buf && memcmp(rsp, __buf, rspLen) == 0)
+			return true;
+	}
 }
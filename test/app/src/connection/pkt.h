@@ -27,3 +27,5 @@ SOFTWARE.
 bool connection_pkt_ping(connection_t* connection, const void* in, uint8_t len);
 
 bool connection_pkt_protocol(connection_t* connection, uint32_t baud, connection_config_e cfg, connection_mode_e mode);
+
+bool connection_pkt_sync(connection_t* connection, uint32_t nonce);
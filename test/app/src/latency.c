@@ -0,0 +1,245 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "latency.h"
+#include "console.h"
+#include "timer.h"
+#include "connection/msg.h"
+#include "connection/pkt.h"
+
+#include <serial.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <inttypes.h>
+
+#define __MSG_MAX_PAYLOAD 122 // __MSG_MAX_LEN - strlen("PING;") - 1
+#define __PKT_MAX_PAYLOAD 253
+#define __DEFAULT_BAUD    9600
+#define __CONFIG          CONNECTION_CONFIG_8N1
+
+typedef struct __stats __stats_t;
+
+struct __stats {
+	connection_mode_e mode;
+	uint32_t          baud;
+	uint32_t          payloadSize;
+	uint32_t          samples;
+	double            min;  // All times in microseconds
+	double            mean;
+	double            p50;
+	double            p90;
+	double            p99;
+	double            max;
+};
+
+static const char* __mode_name(connection_mode_e mode) {
+	return mode == CONNECTION_MODE_MESSAGE ? "message" : "packet";
+}
+
+static int __compare_u64(const void* a, const void* b) {
+	uint64_t mA = *(const uint64_t*)a;
+	uint64_t mB = *(const uint64_t*)b;
+	return (mA > mB) - (mA < mB);
+}
+
+// Nearest-rank percentile of sorted samples
+static double __percentile(const uint64_t* sorted, uint32_t count, uint32_t percent) {
+	uint32_t rank = (uint32_t)(((uint64_t)percent * count + 99) / 100);
+	return sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+
+static bool __switch_protocol(connection_t* connection, connection_mode_e* current, uint32_t* currentBaud, uint32_t baud, connection_mode_e mode) {
+	if (*current == mode && *currentBaud == baud)
+		return true;
+
+	bool result;
+
+	if (*current == CONNECTION_MODE_MESSAGE) {
+		result = connection_msg_protocol(connection, baud, __CONFIG, mode);
+	} else {
+		result = connection_pkt_protocol(connection, baud, __CONFIG, mode);
+	}
+
+	if (result) {
+		*current     = mode;
+		*currentBaud = baud;
+	}
+
+	return result;
+}
+
+static bool __ping(connection_t* connection, connection_mode_e mode, const char* payload, uint32_t payloadSize) {
+	if (mode == CONNECTION_MODE_MESSAGE)
+		return connection_msg_ping(connection, payload);
+
+	return connection_pkt_ping(connection, payload, (uint8_t)payloadSize);
+}
+
+static bool __measure(connection_t* connection, const latency_config_t* config, connection_mode_e mode, uint32_t baud, uint32_t payloadSize, uint64_t* samples, __stats_t* out) {
+	char payload[__PKT_MAX_PAYLOAD + 1];
+
+	// Message payload must be printable and cannot contain the field separator
+	for (uint32_t i = 0; i < payloadSize; i++)
+		payload[i] = mode == CONNECTION_MODE_MESSAGE ? (char)('a' + i % 26) : (char)i;
+
+	payload[payloadSize] = '\0';
+
+	for (uint32_t i = 0; i < config->warmup; i++) {
+		if (!__ping(connection, mode, payload, payloadSize))
+			return false;
+	}
+
+	uint64_t total = 0;
+
+	for (uint32_t i = 0; i < config->count; i++) {
+		uint64_t start = timer_nanos();
+
+		if (!__ping(connection, mode, payload, payloadSize))
+			return false;
+
+		samples[i] = timer_nanos() - start;
+		total += samples[i];
+	}
+
+	qsort(samples, config->count, sizeof(uint64_t), __compare_u64);
+
+	out->mode        = mode;
+	out->baud        = baud;
+	out->payloadSize = payloadSize;
+	out->samples     = config->count;
+	out->min         = samples[0] / 1000.0;
+	out->mean        = total / 1000.0 / config->count;
+	out->p50         = __percentile(samples, config->count, 50);
+	out->p90         = __percentile(samples, config->count, 90);
+	out->p99         = __percentile(samples, config->count, 99);
+	out->max         = samples[config->count - 1] / 1000.0;
+
+	return true;
+}
+
+static bool __write_json(const char* path, const latency_config_t* config, const __stats_t* stats, size_t numStats) {
+	FILE* f = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+
+	if (!f) {
+		console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] Error opening %s\n", path);
+		return false;
+	}
+
+	fprintf(f, "{\n");
+	fprintf(f, "  \"libserial\": \"%s\",\n", serial_version());
+	fprintf(f, "  \"count\": %" PRIu32 ",\n", config->count);
+	fprintf(f, "  \"warmup\": %" PRIu32 ",\n", config->warmup);
+	fprintf(f, "  \"results\": [");
+
+	for (size_t i = 0; i < numStats; i++) {
+		const __stats_t* s = &stats[i];
+
+		fprintf(f,
+			"%s\n    {\"mode\": \"%s\", \"baud\": %" PRIu32 ", \"payload\": %" PRIu32 ", \"samples\": %" PRIu32 ", "
+			"\"min_us\": %.1f, \"mean_us\": %.1f, \"p50_us\": %.1f, \"p90_us\": %.1f, \"p99_us\": %.1f, \"max_us\": %.1f}",
+			i > 0 ? "," : "", __mode_name(s->mode), s->baud, s->payloadSize, s->samples,
+			s->min, s->mean, s->p50, s->p90, s->p99, s->max
+		);
+	}
+
+	fprintf(f, "\n  ]\n}\n");
+
+	return f == stdout ? fflush(f) == 0 : fclose(f) == 0;
+}
+
+bool latency_run(connection_t* connection, const latency_config_t* config) {
+	connection_mode_e modes[2];
+	size_t numModes = 0;
+
+	if (config->message)
+		modes[numModes++] = CONNECTION_MODE_MESSAGE;
+
+	if (config->packet)
+		modes[numModes++] = CONNECTION_MODE_PACKET;
+
+	if (config->count == 0 || numModes == 0 || config->numBauds == 0 || config->numPayloadSizes == 0) {
+		errno = SERIAL_ERROR_INVALID_PARAM;
+		return false;
+	}
+
+	for (size_t i = 0; i < config->numPayloadSizes; i++) {
+		uint32_t maxPayload = config->message ? __MSG_MAX_PAYLOAD : __PKT_MAX_PAYLOAD;
+
+		if (config->payloadSizes[i] > maxPayload) {
+			console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] Payload size %" PRIu32 " exceeds maximum (%" PRIu32 ")\n", config->payloadSizes[i], maxPayload);
+			errno = SERIAL_ERROR_INVALID_PARAM;
+			return false;
+		}
+	}
+
+	size_t     maxStats = numModes * config->numBauds * config->numPayloadSizes;
+	size_t     numStats = 0;
+	__stats_t* stats    = malloc(maxStats * sizeof(__stats_t));
+	uint64_t*  samples  = malloc(config->count * sizeof(uint64_t));
+	bool       result   = false;
+
+	connection_mode_e currentMode = CONNECTION_MODE_MESSAGE;
+	uint32_t          currentBaud = __DEFAULT_BAUD;
+
+	if (!stats || !samples) {
+		errno = SERIAL_ERROR_MEM;
+		goto end;
+	}
+
+	console_printf("%-8s %8s %8s %10s %10s %10s %10s %10s\n", "mode", "baud", "payload", "min(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+
+	for (size_t m = 0; m < numModes; m++) {
+		for (size_t b = 0; b < config->numBauds; b++) {
+			if (!__switch_protocol(connection, &currentMode, &currentBaud, config->bauds[b], modes[m]))
+				goto end;
+
+			for (size_t p = 0; p < config->numPayloadSizes; p++) {
+				__stats_t* s = &stats[numStats];
+
+				if (!__measure(connection, config, modes[m], config->bauds[b], config->payloadSizes[p], samples, s))
+					goto end;
+
+				numStats++;
+				console_printf("%-8s %8" PRIu32 " %8" PRIu32 " %10.1f %10.1f %10.1f %10.1f %10.1f\n", __mode_name(s->mode), s->baud, s->payloadSize, s->min, s->p50, s->p90, s->p99, s->max);
+				console_flush();
+			}
+		}
+	}
+
+	result = true;
+
+end:
+	if (stats && config->jsonPath && numStats > 0) {
+		int previousError = errno;
+		result = __write_json(config->jsonPath, config, stats, numStats) && result;
+		errno = previousError;
+	}
+
+	if (result)
+		result = __switch_protocol(connection, &currentMode, &currentBaud, __DEFAULT_BAUD, CONNECTION_MODE_MESSAGE);
+
+	free(stats);
+	free(samples);
+	return result;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include "connection.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct latency_config latency_config_t;
+
+struct latency_config {
+	uint32_t        count;           // PINGs per combination
+	uint32_t        warmup;          // PINGs discarded before measuring
+	const uint32_t* payloadSizes;
+	size_t          numPayloadSizes;
+	const uint32_t* bauds;
+	size_t          numBauds;
+	bool            message;         // Measure MESSAGE mode
+	bool            packet;          // Measure PACKET mode
+	const char*     jsonPath;        // JSON report ("-": stdout, NULL: none)
+};
+
+/**
+ * Measures PING round-trip time for each combination of mode, baud rate
+ * and payload size. Connection is expected to be in MESSAGE mode (9600,
+ * 8N1) and it is restored to that state at the end.
+*/
+bool latency_run(connection_t* connection, const latency_config_t* config);
@@ -23,53 +23,191 @@ SOFTWARE.
 #include <serial.h>
 
 #include "console.h"
+#include "latency.h"
 #include "connection/msg.h"
 #include "connection/pkt.h"
 
 #include <string.h>
+#include <stdlib.h>
 #include <errno.h>
+#include <getopt.h>
+
+#define __MAX_LIST_ITEMS 16
 
 #define __ASSERT(cond) if (!(cond)) { console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ASSERTION ERROR][%s:%d] errno: %d (%s)\n", __FILE__, __LINE__, errno, serial_error_to_str(errno)); return 1; }
 
-int main(int argc, char** argv) {
-	serial_list_t* list = serial_list_new();
+static void __usage(const char* cmd) {
+	console_printf(
+		"Usage: %s [port]\n"
+		"       %s latency [options] [port]\n"
+		"\n"
+		"Without a command, runs functional tests against the test firmware.\n"
+		"\n"
+		"latency: measures PING round-trip time against the test firmware\n"
+		"  -n, --count <n>           PINGs per combination (default: 1000)\n"
+		"  -w, --warmup <n>          PINGs discarded before measuring (default: 10)\n"
+		"  -p, --payload-sizes <l>   Comma-separated payload sizes (default: 1,16,64)\n"
+		"  -b, --bauds <list>        Comma-separated baud rates (default: 9600,115200)\n"
+		"  -m, --modes <list>        message,packet (default: both)\n"
+		"  -j, --json <file>         Writes a JSON report ('-': stdout)\n",
+		cmd, cmd
+	);
+}
 
-	if (!serial_list_ports(list)) {
-		console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] Error listing serial ports\n");
-		return 1;
-	}
+static int __parse_list(const char* str, uint32_t* out, int maxItems) {
+	int count = 0;
+	char* end;
 
-	if (serial_list_size(list) == 0) {
-		console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] There is no serial ports\n");
-		return 1;
+	while (*str) {
+		if (count == maxItems)
+			return -1;
+
+		out[count++] = (uint32_t)strtoul(str, &end, 10);
+
+		if (end == str || (*end != ',' && *end != '\0'))
+			return -1;
+
+		str = *end ? end + 1 : end;
 	}
 
-	const char* portName;
-	if (serial_list_size(list) == 1) {
-		portName = serial_list_item(list, 0);
-	} else {
-		console_printf("Available serial ports\n\n");
-		for (size_t i = 0; i < serial_list_size(list); i++) {
-			console_printf("%zu) %s\n", i, serial_list_item(list, i));
+	return count;
+}
+
+// If portName is NULL, port is chosen from available ones
+static connection_t* __open_connection(const char* portName) {
+	serial_list_t* list = NULL;
+
+	if (!portName) {
+		list = serial_list_new();
+
+		if (!serial_list_ports(list)) {
+			console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] Error listing serial ports\n");
+			serial_list_del(list);
+			return NULL;
 		}
 
-		console_printf("\n");
-		int option = console_get_num_option("Choose a port: ", serial_list_size(list));
-		portName = serial_list_item(list, option);
+		if (serial_list_size(list) == 0) {
+			console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] There is no serial ports\n");
+			serial_list_del(list);
+			return NULL;
+		}
+
+		if (serial_list_size(list) == 1) {
+			portName = serial_list_item(list, 0);
+		} else {
+			console_printf("Available serial ports\n\n");
+			for (size_t i = 0; i < serial_list_size(list); i++) {
+				console_printf("%zu) %s\n", i, serial_list_item(list, i));
+			}
+
+			console_printf("\n");
+			int option = console_get_num_option("Choose a port: ", serial_list_size(list));
+			portName = serial_list_item(list, option);
+		}
 	}
 
-		console_printf("Opening port %s... ", portName);
-		console_flush();
+	console_printf("Opening port %s... ", portName);
+	console_flush();
 
 	connection_t* connection = connection_open(portName);
 	if (!connection) {
 		console_color_printf(CONSOLE_ANSI_COLOR_BRIGHT_RED, "[ERROR] Error opening serial port %s: %s\n", portName, serial_error_to_str(errno));
-		return 1;
 	} else {
 		console_printf("DONE!\n");
 	}
 
-	serial_list_del(list);
+	if (list)
+		serial_list_del(list);
+
+	return connection;
+}
+
+static int __latency(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "count",         required_argument, NULL, 'n' },
+		{ "warmup",        required_argument, NULL, 'w' },
+		{ "payload-sizes", required_argument, NULL, 'p' },
+		{ "bauds",         required_argument, NULL, 'b' },
+		{ "modes",         required_argument, NULL, 'm' },
+		{ "json",          required_argument, NULL, 'j' },
+		{ "help",          no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	uint32_t payloadSizes[__MAX_LIST_ITEMS] = { 1, 16, 64 };
+	uint32_t bauds[__MAX_LIST_ITEMS]        = { 9600, 115200 };
+	int      numPayloadSizes = 3;
+	int      numBauds        = 2;
+	int      opt;
+
+	latency_config_t config = {
+		.count    = 1000,
+		.warmup   = 10,
+		.message  = true,
+		.packet   = true,
+		.jsonPath = NULL
+	};
+
+	while ((opt = getopt_long(argc, argv, "n:w:p:b:m:j:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'n': config.count = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'w': config.warmup = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'p': numPayloadSizes = __parse_list(optarg, payloadSizes, __MAX_LIST_ITEMS); break;
+		case 'b': numBauds = __parse_list(optarg, bauds, __MAX_LIST_ITEMS); break;
+		case 'j': config.jsonPath = optarg; break;
+
+		case 'm':
+			config.message = strstr(optarg, "message") != NULL;
+			config.packet  = strstr(optarg, "packet") != NULL;
+			break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (numPayloadSizes <= 0 || numBauds <= 0 || argc - optind > 1) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	config.payloadSizes    = payloadSizes;
+	config.numPayloadSizes = (size_t)numPayloadSizes;
+	config.bauds           = bauds;
+	config.numBauds        = (size_t)numBauds;
+
+	connection_t* connection = __open_connection(optind < argc ? argv[optind] : NULL);
+
+	if (!connection)
+		return 1;
+
+	__ASSERT(latency_run(connection, &config));
+	__ASSERT(connection_close(connection));
+
+	return 0;
+}
+
+int main(int argc, char** argv) {
+	if (argc > 1 && strcmp(argv[1], "latency") == 0) {
+		argv[1] = argv[0];
+		return __latency(argc - 1, argv + 1);
+	}
+
+	if (argc > 2 || (argc == 2 && (strcmp(argv[1], "-h") == 0 || strcmp(argv[1], "--help") == 0))) {
+		__usage(argv[0]);
+		return argc == 2 ? 0 : 1;
+	}
+
+	connection_t* connection = __open_connection(argc > 1 ? argv[1] : NULL);
+
+	if (!connection)
+		return 1;
+
 	__ASSERT(connection_config(connection, 9600, CONNECTION_CONFIG_8N1));
 
 	console_printf("[MSG] PING test... "); console_flush();
@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "allocs.h"
+
+#include <stddef.h>
+
+// Wrapped symbols are resolved at link time (see -Wl,--wrap on Makefile)
+
+static uint64_t __count = 0;
+
+#define __COUNT() __atomic_fetch_add(&__count, 1, __ATOMIC_RELAXED)
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t nmemb, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+	__COUNT();
+	return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t nmemb, size_t size) {
+	__COUNT();
+	return __real_calloc(nmemb, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+	__COUNT();
+	return __real_realloc(ptr, size);
+}
+
+void allocs_reset() {
+	__atomic_store_n(&__count, 0, __ATOMIC_RELAXED);
+}
+
+uint64_t allocs_count() {
+	return __atomic_load_n(&__count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+
+uint64_t bench_nanos() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+int bench_parse_list(const char* str, uint32_t* out, int maxItems) {
+	int count = 0;
+	char* end;
+
+	while (*str) {
+		if (count == maxItems)
+			return -1;
+
+		unsigned long value = strtoul(str, &end, 10);
+
+		if (end == str || (*end != ',' && *end != '\0'))
+			return -1;
+
+		out[count++] = (uint32_t)value;
+		str = *end ? end + 1 : end;
+	}
+
+	return count;
+}
+
+static bool __open_endpoint(bench_endpoint_t* endpoint, int fd, uint32_t baud) {
+	serial_t* port = serial_open_fd(fd, SERIAL_OPEN_FLAG_KEEP_FD);
+
+	if (!port) {
+		fprintf(stderr, "Error opening fd:%d: %s\n", fd, serial_error_to_str(errno));
+		return false;
+	}
+
+	serial_config_t config;
+	serial_get_config(port, &config);
+	config.baud = baud;
+
+	if (!serial_config(port, &config)) {
+		fprintf(stderr, "Error configuring fd:%d: %s\n", fd, serial_error_to_str(errno));
+		serial_close(port);
+		return false;
+	}
+
+	// Descriptor is owned by the endpoint only on success
+	endpoint->port = port;
+	endpoint->fd   = fd;
+	return true;
+}
+
+static int __open_device(const char* name) {
+	int fd = open(name, O_RDWR | O_NOCTTY);
+
+	if (fd < 0)
+		fprintf(stderr, "Error opening %s: %s\n", name, strerror(errno));
+
+	return fd;
+}
+
+bool bench_open_pair(bench_pair_t* pair, const char* nameA, const char* nameB, uint32_t baud) {
+	int fdA = -1;
+	int fdB = -1;
+
+	memset(pair, 0, sizeof(bench_pair_t));
+	pair->a.fd = -1;
+	pair->b.fd = -1;
+
+	if (!nameA) {
+		// Descriptors are opened here (instead of serial_create_virtual_pair())
+		// so that raw system calls can be compared against the library.
+		char slaveName[64];
+
+		if ((fdA = posix_openpt(O_RDWR | O_NOCTTY)) < 0 || grantpt(fdA) < 0 || unlockpt(fdA) < 0 || ptsname_r(fdA, slaveName, sizeof(slaveName)) != 0) {
+			fprintf(stderr, "Error creating pseudo-terminal: %s\n", strerror(errno));
+			goto error;
+		}
+
+		if ((fdB = __open_device(slaveName)) < 0)
+			goto error;
+	} else {
+		if ((fdA = __open_device(nameA)) < 0)
+			goto error;
+
+		if (nameB && (fdB = __open_device(nameB)) < 0)
+			goto error;
+	}
+
+	if (!__open_endpoint(&pair->a, fdA, baud))
+		goto error;
+
+	fdA = -1;
+
+	if (fdB < 0) {
+		pair->b      = pair->a;
+		pair->shared = true;
+		return true;
+	}
+
+	if (!__open_endpoint(&pair->b, fdB, baud))
+		goto error;
+
+	return true;
+
+error:
+	if (fdA >= 0)
+		close(fdA);
+
+	if (fdB >= 0)
+		close(fdB);
+
+	bench_close_pair(pair);
+	return false;
+}
+
+static void __close_endpoint(bench_endpoint_t* endpoint) {
+	if (endpoint->port)
+		serial_close(endpoint->port);
+
+	if (endpoint->fd >= 0)
+		close(endpoint->fd);
+
+	endpoint->port = NULL;
+	endpoint->fd   = -1;
+}
+
+void bench_close_pair(bench_pair_t* pair) {
+	// Pseudo-terminal slave (reader) is closed before the master one
+	if (!pair->shared)
+		__close_endpoint(&pair->b);
+
+	__close_endpoint(&pair->a);
+}
@@ -0,0 +1,65 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <serial.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+typedef struct bench_endpoint bench_endpoint_t;
+typedef struct bench_pair bench_pair_t;
+
+struct bench_endpoint {
+	serial_t* port;
+	int       fd;   // Underlying descriptor (owned by the bench)
+};
+
+struct bench_pair {
+	bench_endpoint_t a;      // Writer
+	bench_endpoint_t b;      // Reader (same as writer on single-port loopback)
+	bool             shared; // Whether a and b are the same port
+};
+
+uint64_t bench_nanos();
+
+/** Parses a comma-separated list of unsigned numbers (returns number of items or -1 on error). */
+int bench_parse_list(const char* str, uint32_t* out, int maxItems);
+
+/**
+ * Opens a pair of connected endpoints: a pseudo-terminal pair when no
+ * names are given, a single port (TX looped back to RX) when only nameA is
+ * given, or two ports wired to each other.
+*/
+bool bench_open_pair(bench_pair_t* pair, const char* nameA, const char* nameB, uint32_t baud);
+
+void bench_close_pair(bench_pair_t* pair);
+
+int bench_throughput(int argc, char** argv);
+
+int bench_scaling(int argc, char** argv);
+
+int bench_enum(int argc, char** argv);
+
+int bench_micro(int argc, char** argv);
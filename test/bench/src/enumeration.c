@@ -0,0 +1,312 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#define _GNU_SOURCE
+#include "bench.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#define __MAX_ITEMS     16
+#define __ROOT_ENV      "LIBSERIAL_DEV_ROOT"
+#define __ROOT_TEMPLATE "/tmp/serial-enum-XXXXXX"
+#define __SYS_ROOT_ENV      "LIBSERIAL_SYS_ROOT"
+#define __SYS_ROOT_TEMPLATE "/tmp/serial-sys-XXXXXX"
+#define __MAX_MATCHING  (__NUM_PREFIXES * 1000)
+
+static const char* __PREFIXES[] = { "ttyS", "ttyUSB", "ttyACM", "ttyAMA", "rfcomm", "ttyO" };
+
+#define __NUM_PREFIXES (sizeof(__PREFIXES) / sizeof(__PREFIXES[0]))
+
+// Entry names: matching ones are listed by the library, others only scanned
+static void __entry_name(char* out, size_t szOut, uint32_t index, uint32_t matching) {
+	if (index < matching) {
+		snprintf(out, szOut, "%s%u", __PREFIXES[index % __NUM_PREFIXES], index / (uint32_t)__NUM_PREFIXES);
+	} else {
+		snprintf(out, szOut, "dev%u", index);
+	}
+}
+
+static void __remove_tree(const char* root, uint32_t entries, uint32_t matching) {
+	char path[256];
+	char name[32];
+
+	for (uint32_t i = 0; i < entries; i++) {
+		__entry_name(name, sizeof(name), i, matching);
+		snprintf(path, sizeof(path), "%s/%s", root, name);
+		unlink(path);
+	}
+
+	rmdir(root);
+}
+
+// Paths of the synthetic sysfs tree, from the innermost one
+static int __sys_paths(char paths[][256], const char* root, const char* ttyName) {
+	struct stat st;
+
+	if (stat(ttyName, &st) < 0)
+		return -1;
+
+	snprintf(paths[0], 256, "%s/dev/char/%u:%u/device", root, major(st.st_rdev), minor(st.st_rdev));
+	snprintf(paths[1], 256, "%s/dev/char/%u:%u", root, major(st.st_rdev), minor(st.st_rdev));
+	snprintf(paths[2], 256, "%s/dev/char", root);
+	snprintf(paths[3], 256, "%s/dev", root);
+	return 4;
+}
+
+static void __remove_sys_tree(const char* root, const char* ttyName) {
+	char paths[4][256];
+	int count = __sys_paths(paths, root, ttyName);
+
+	for (int i = 0; i < count; i++)
+		rmdir(paths[i]);
+
+	rmdir(root);
+}
+
+/*
+ * Builds a synthetic sysfs tree, where the pseudo-terminal slave is reported
+ * as backed by a device (ports are listed only then).
+*/
+static bool __build_sys_tree(char* root, const char* ttyName) {
+	char paths[4][256];
+	int count;
+
+	if (!mkdtemp(root)) {
+		fprintf(stderr, "Error creating %s: %s\n", root, strerror(errno));
+		return false;
+	}
+
+	if ((count = __sys_paths(paths, root, ttyName)) < 0) {
+		fprintf(stderr, "Error reading %s: %s\n", ttyName, strerror(errno));
+		rmdir(root);
+		return false;
+	}
+
+	for (int i = count - 1; i >= 0; i--) {
+		if (mkdir(paths[i], 0700) < 0) {
+			fprintf(stderr, "Error creating %s: %s\n", paths[i], strerror(errno));
+			__remove_sys_tree(root, ttyName);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * Builds a synthetic device tree. Matching entries are links to a single
+ * pseudo-terminal slave (so they can be probed), other ones are links to
+ * /dev/null.
+*/
+static bool __build_tree(char* root, const char* ttyName, uint32_t entries, uint32_t matching) {
+	char path[256];
+	char name[32];
+
+	if (!mkdtemp(root)) {
+		fprintf(stderr, "Error creating %s: %s\n", root, strerror(errno));
+		return false;
+	}
+
+	for (uint32_t i = 0; i < entries; i++) {
+		__entry_name(name, sizeof(name), i, matching);
+		snprintf(path, sizeof(path), "%s/%s", root, name);
+
+		if (symlink(i < matching ? ttyName : "/dev/null", path) < 0) {
+			fprintf(stderr, "Error creating %s: %s\n", path, strerror(errno));
+			__remove_tree(root, i, matching);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool __run(const char* ttyName, uint32_t entries, uint32_t matching, uint32_t iterations, bool csv) {
+	char root[] = __ROOT_TEMPLATE;
+	bool result = false;
+
+	if (!__build_tree(root, ttyName, entries, matching))
+		return false;
+
+	setenv(__ROOT_ENV, root, 1);
+
+	uint64_t total = 0;
+	uint64_t min   = UINT64_MAX;
+	uint64_t max   = 0;
+	size_t   found = 0;
+
+	for (uint32_t i = 0; i < iterations; i++) {
+		serial_list_t* list = serial_list_new();
+
+		if (!list) {
+			fprintf(stderr, "Out of memory\n");
+			goto end;
+		}
+
+		uint64_t start = bench_nanos();
+		bool listed = serial_list_ports(list) != NULL;
+		uint64_t elapsed = bench_nanos() - start;
+
+		found = serial_list_size(list);
+		serial_list_del(list);
+
+		if (!listed) {
+			fprintf(stderr, "Error listing ports: %s\n", serial_error_to_str(errno));
+			goto end;
+		}
+
+		total += elapsed;
+		min = elapsed < min ? elapsed : min;
+		max = elapsed > max ? elapsed : max;
+	}
+
+	double mean = (double)total / iterations;
+
+	if (csv) {
+		printf("%u,%u,%zu,%.3f,%.3f,%.3f,%.3f\n", entries, matching, found, min / 1e6, mean / 1e6, max / 1e6, entries ? mean / 1e3 / entries : 0);
+	} else {
+		printf("%8u %9u %7zu %10.3f %10.3f %10.3f %12.3f\n", entries, matching, found, min / 1e6, mean / 1e6, max / 1e6, entries ? mean / 1e3 / entries : 0);
+	}
+
+	fflush(stdout);
+
+	if (found != matching) {
+		fprintf(stderr, "Expected %u ports, found %zu\n", matching, found);
+		goto end;
+	}
+
+	result = true;
+
+end:
+	unsetenv(__ROOT_ENV);
+	__remove_tree(root, entries, matching);
+	return result;
+}
+
+static void __usage(const char* cmd) {
+	printf(
+		"Usage: %s enum [options]\n"
+		"\n"
+		"Times serial_list_ports() over synthetic device and sysfs trees (scan\n"
+		"roots are given to the library, which is built with TEST_HOOKS=1,\n"
+		"through " __ROOT_ENV " and " __SYS_ROOT_ENV ").\n"
+		"\n"
+		"Options:\n"
+		"  -e, --entries <list>    Directory entries (default: 1000,10000)\n"
+		"  -m, --matching <list>   Entries matching port names, which are probed\n"
+		"                          (default: 0,10,100; max: %u)\n"
+		"  -i, --iterations <n>    Listings per combination (default: 20)\n"
+		"      --csv               CSV output\n",
+		cmd, (uint32_t)__MAX_MATCHING
+	);
+}
+
+int bench_enum(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "entries",    required_argument, NULL, 'e' },
+		{ "matching",   required_argument, NULL, 'm' },
+		{ "iterations", required_argument, NULL, 'i' },
+		{ "csv",        no_argument,       NULL, 'C' },
+		{ "help",       no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	uint32_t entries[__MAX_ITEMS]  = { 1000, 10000 };
+	uint32_t matching[__MAX_ITEMS] = { 0, 10, 100 };
+	int      numEntries  = 2;
+	int      numMatching = 3;
+	uint32_t iterations  = 20;
+	bool     csv         = false;
+	int      opt;
+
+	while ((opt = getopt_long(argc, argv, "e:m:i:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'e': numEntries = bench_parse_list(optarg, entries, __MAX_ITEMS); break;
+		case 'm': numMatching = bench_parse_list(optarg, matching, __MAX_ITEMS); break;
+		case 'i': iterations = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'C': csv = true; break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (numEntries <= 0 || numMatching <= 0 || iterations == 0) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	// Probed entries are links to the slave of a pseudo-terminal pair kept
+	// open during the benchmark.
+	char ttyName[64];
+	int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+	if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 || ptsname_r(master, ttyName, sizeof(ttyName)) != 0) {
+		fprintf(stderr, "Error creating pseudo-terminal: %s\n", strerror(errno));
+		return 1;
+	}
+
+	char sysRoot[] = __SYS_ROOT_TEMPLATE;
+
+	if (!__build_sys_tree(sysRoot, ttyName)) {
+		close(master);
+		return 1;
+	}
+
+	setenv(__SYS_ROOT_ENV, sysRoot, 1);
+
+	if (csv) {
+		printf("entries,matching,found,min_ms,mean_ms,max_ms,us_per_entry\n");
+	} else {
+		printf("%8s %9s %7s %10s %10s %10s %12s\n", "entries", "matching", "found", "min(ms)", "mean(ms)", "max(ms)", "us/entry");
+	}
+
+	int exitCode = 0;
+
+	for (int e = 0; e < numEntries; e++) {
+		for (int m = 0; m < numMatching; m++) {
+			if (matching[m] > entries[e] || matching[m] > __MAX_MATCHING)
+				continue;
+
+			if (!__run(ttyName, entries[e], matching[m], iterations, csv))
+				exitCode = 1;
+		}
+	}
+
+	unsetenv(__SYS_ROOT_ENV);
+	__remove_sys_tree(sysRoot, ttyName);
+	close(master);
+	return exitCode;
+}
@@ -0,0 +1,90 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "hist.h"
+
+#include <string.h>
+
+#define __SUB_BUCKETS (1 << HIST_SUB_BITS)
+
+static uint32_t __index(uint64_t value) {
+	if (value < __SUB_BUCKETS)
+		return (uint32_t)value;
+
+	uint32_t msb = 63 - (uint32_t)__builtin_clzll(value);
+	return ((msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) + (uint32_t)((value >> (msb - HIST_SUB_BITS)) & (__SUB_BUCKETS - 1));
+}
+
+// Returns the upper bound of given bucket
+static uint64_t __value(uint32_t index) {
+	if (index < __SUB_BUCKETS)
+		return index;
+
+	uint32_t msb = (index >> HIST_SUB_BITS) + HIST_SUB_BITS - 1;
+	uint64_t sub = index & (__SUB_BUCKETS - 1);
+	return ((__SUB_BUCKETS + sub + 1) << (msb - HIST_SUB_BITS)) - 1;
+}
+
+void hist_clear(hist_t* hist) {
+	memset(hist, 0, sizeof(hist_t));
+}
+
+void hist_add(hist_t* hist, uint64_t value) {
+	hist->counts[__index(value)]++;
+	hist->total++;
+	hist->sum += value;
+
+	if (value > hist->max)
+		hist->max = value;
+}
+
+void hist_merge(hist_t* dest, const hist_t* src) {
+	for (uint32_t i = 0; i < HIST_BUCKETS; i++)
+		dest->counts[i] += src->counts[i];
+
+	dest->total += src->total;
+	dest->sum   += src->sum;
+
+	if (src->max > dest->max)
+		dest->max = src->max;
+}
+
+uint64_t hist_percentile(const hist_t* hist, double percent) {
+	if (hist->total == 0)
+		return 0;
+
+	uint64_t rank = (uint64_t)(percent / 100.0 * hist->total + 0.5);
+	uint64_t count = 0;
+
+	rank = rank == 0 ? 1 : rank;
+
+	for (uint32_t i = 0; i < HIST_BUCKETS; i++) {
+		count += hist->counts[i];
+
+		if (count >= rank) {
+			uint64_t value = __value(i);
+			return value > hist->max ? hist->max : value;
+		}
+	}
+
+	return hist->max;
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define HIST_SUB_BITS 4
+#define HIST_BUCKETS  (64 << HIST_SUB_BITS)
+
+typedef struct hist hist_t;
+
+/**
+ * Log-linear histogram (each power of two is split into 2^HIST_SUB_BITS
+ * buckets, giving ~6% resolution) for recording latencies without
+ * storing samples.
+*/
+struct hist {
+	uint64_t counts[HIST_BUCKETS];
+	uint64_t total;
+	uint64_t sum;
+	uint64_t max;
+};
+
+void hist_clear(hist_t* hist);
+
+void hist_add(hist_t* hist, uint64_t value);
+
+void hist_merge(hist_t* dest, const hist_t* src);
+
+/** Returns the value below which given percentage (0-100) of samples fall. */
+uint64_t hist_percentile(const hist_t* hist, double percent);
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.h"
+
+#include <stdio.h>
+#include <string.h>
+
+typedef struct __command __command_t;
+
+struct __command {
+	const char* name;
+	int (*run)(int argc, char** argv);
+	const char* description;
+};
+
+static const __command_t __COMMANDS[] = {
+	{ "throughput", bench_throughput, "Streaming throughput between two endpoints" },
+	{ "scaling",    bench_scaling,    "Concurrent echo round trips over many ports" },
+	{ "enum",       bench_enum,       "Port enumeration over synthetic device trees" },
+	{ "micro",      bench_micro,      "Library-side cost per call (null:// mock port)" },
+	{ NULL, NULL, NULL }
+};
+
+static void __usage(const char* cmd) {
+	printf("Usage: %s <command> [options]\n\nCommands:\n", cmd);
+
+	for (const __command_t* command = __COMMANDS; command->name; command++)
+		printf("  %-12s %s\n", command->name, command->description);
+
+	printf("\nUse '%s <command> --help' for command options.\n", cmd);
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	for (const __command_t* command = __COMMANDS; command->name; command++) {
+		if (strcmp(argv[1], command->name) == 0) {
+			argv[1] = argv[0];
+			return command->run(argc - 1, argv + 1);
+		}
+	}
+
+	__usage(argv[0]);
+	return strcmp(argv[1], "--help") == 0 ? 0 : 1;
+}
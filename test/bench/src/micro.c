@@ -0,0 +1,238 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.h"
+#include "allocs.h"
+#include "syscalls.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+
+#define __MAX_BUFFER 4096
+#define __REPEATS    5 // Best of
+
+typedef struct __case __case_t;
+typedef struct __context __context_t;
+
+struct __context {
+	serial_t*       source; // null://
+	serial_t*       empty;  // null://empty
+	serial_config_t configs[2];
+	uint8_t         buffer[__MAX_BUFFER];
+	volatile int    sink;   // Keeps results alive
+};
+
+struct __case {
+	const char* name;
+	uint32_t    size;
+	bool (*op)(__context_t* ctx, uint32_t size, uint64_t i);
+};
+
+static bool __read(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_read(ctx->source, ctx->buffer, size) == (int32_t)size;
+}
+
+static bool __read_discard(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_read(ctx->source, NULL, size) == (int32_t)size;
+}
+
+static bool __read_empty(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_read(ctx->empty, ctx->buffer, size) == 0;
+}
+
+static bool __read_timeout(__context_t* ctx, uint32_t size, uint64_t i) {
+	// Backend times out instantly, so this measures timeout bookkeeping only
+	return serial_read(ctx->empty, ctx->buffer, size) < 0 && errno == SERIAL_ERROR_TIMEOUT;
+}
+
+static bool __write(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_write(ctx->source, ctx->buffer, size);
+}
+
+static bool __available(__context_t* ctx, uint32_t size, uint64_t i) {
+	ctx->sink = serial_available(ctx->source);
+	return true;
+}
+
+static bool __config_same(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_config(ctx->source, &ctx->configs[0]);
+}
+
+static bool __config_change(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_config(ctx->source, &ctx->configs[i & 1]);
+}
+
+static bool __set_read_timeout(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_set_read_timeout(ctx->source, (uint32_t)(i & 1) * 100);
+}
+
+static bool __discard(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_discard(ctx->empty, 0, 0) == 0;
+}
+
+static bool __flush(__context_t* ctx, uint32_t size, uint64_t i) {
+	return serial_flush(ctx->source);
+}
+
+static const __case_t __CASES[] = {
+	{ "serial_read",             1,    __read },
+	{ "serial_read",             64,   __read },
+	{ "serial_read",             4096, __read },
+	{ "serial_read(NULL)",       64,   __read_discard },
+	{ "serial_read(empty)",      64,   __read_empty },
+	{ "serial_read(timeout)",    64,   __read_timeout },
+	{ "serial_write",            1,    __write },
+	{ "serial_write",            64,   __write },
+	{ "serial_write",            4096, __write },
+	{ "serial_available",        0,    __available },
+	{ "serial_config(same)",     0,    __config_same },
+	{ "serial_config(change)",   0,    __config_change },
+	{ "serial_set_read_timeout", 0,    __set_read_timeout },
+	{ "serial_flush",            0,    __flush },
+	{ "serial_discard",          0,    __discard },
+	{ NULL, 0, NULL }
+};
+
+static bool __run_case(__context_t* ctx, const __case_t* c, uint64_t iterations, bool csv) {
+	double   best    = 0;
+	uint64_t allocs  = 0;
+	uint64_t syscalls = 0;
+
+	// Timeout bookkeeping is measured with a non-zero timeout; other cases use 0
+	if (!serial_set_read_timeout(ctx->empty, c->op == __read_timeout ? 100 : 0) || !serial_set_read_timeout(ctx->source, 0))
+		return false;
+
+	for (int r = 0; r < __REPEATS; r++) {
+		allocs_reset();
+		syscalls_reset();
+		uint64_t start = bench_nanos();
+
+		for (uint64_t i = 0; i < iterations; i++) {
+			if (!c->op(ctx, c->size, i)) {
+				fprintf(stderr, "%s(%u) failed: %s\n", c->name, c->size, serial_error_to_str(errno));
+				return false;
+			}
+		}
+
+		double nsPerOp = (double)(bench_nanos() - start) / iterations;
+
+		if (r == 0 || nsPerOp < best)
+			best = nsPerOp;
+
+		allocs   = allocs_count();
+		syscalls = syscalls_count();
+	}
+
+	if (csv) {
+		printf("%s,%u,%.2f,%.4f,%.4f\n", c->name, c->size, best, (double)allocs / iterations, (double)syscalls / iterations);
+	} else {
+		printf("%-24s %6u %10.2f %10.4f %12.4f\n", c->name, c->size, best, (double)allocs / iterations, (double)syscalls / iterations);
+	}
+
+	fflush(stdout);
+	return true;
+}
+
+static void __usage(const char* cmd) {
+	printf(
+		"Usage: %s micro [options]\n"
+		"\n"
+		"Measures library-side cost of API calls on top of the null:// mock\n"
+		"backend (no kernel involved), reporting ns/op (best of %d runs),\n"
+		"heap allocations/op and system calls/op.\n"
+		"\n"
+		"Options:\n"
+		"  -n, --iterations <n>   Calls per run (default: 1000000)\n"
+		"      --csv              CSV output\n",
+		cmd, __REPEATS
+	);
+}
+
+int bench_micro(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "iterations", required_argument, NULL, 'n' },
+		{ "csv",        no_argument,       NULL, 'C' },
+		{ "help",       no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	uint64_t iterations = 1000000;
+	bool     csv        = false;
+	int      opt;
+
+	while ((opt = getopt_long(argc, argv, "n:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'n': iterations = strtoull(optarg, NULL, 10); break;
+		case 'C': csv = true; break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (iterations == 0) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	static __context_t ctx;
+	int exitCode = 1;
+
+	if (!(ctx.source = serial_open("null://")) || !(ctx.empty = serial_open("null://empty"))) {
+		fprintf(stderr, "Error opening null port: %s\n", serial_error_to_str(errno));
+		goto end;
+	}
+
+	serial_get_config(ctx.source, &ctx.configs[0]);
+	ctx.configs[1] = ctx.configs[0];
+	ctx.configs[1].baud = 115200;
+
+	if (csv) {
+		printf("operation,size,ns_per_op,allocs_per_op,syscalls_per_op\n");
+	} else {
+		printf("%-24s %6s %10s %10s %12s\n", "operation", "size", "ns/op", "allocs/op", "syscalls/op");
+	}
+
+	for (const __case_t* c = __CASES; c->name; c++) {
+		if (!__run_case(&ctx, c, iterations, csv))
+			goto end;
+	}
+
+	exitCode = 0;
+
+end:
+	if (ctx.source)
+		serial_close(ctx.source);
+
+	if (ctx.empty)
+		serial_close(ctx.empty);
+
+	return exitCode;
+}
@@ -0,0 +1,499 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.h"
+#include "hist.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#ifdef __linux__
+	#include <sys/epoll.h>
+	#define __HAS_EPOLL 1
+#else
+	#define __HAS_EPOLL 0
+#endif
+
+#define __MAX_ITEMS        16
+#define __MAX_MESSAGE_SIZE 4096
+#define __THREAD_STACK     (64 * 1024)
+#define __READ_TIMEOUT     1000
+#define __WAIT_MILLIS      100
+
+typedef enum __strategy __strategy_e;
+typedef struct __port __port_t;
+typedef struct __run __run_t;
+
+enum __strategy {
+	__STRATEGY_THREAD, // One blocking thread per port
+	__STRATEGY_POLL,   // Single thread, poll() loop
+	__STRATEGY_EPOLL,  // Single thread, epoll reactor
+	__STRATEGY_COUNT
+};
+
+static const char* __STRATEGY_NAMES[] = { "thread", "poll", "epoll" };
+
+struct __port {
+	bench_pair_t pair;     // a: echo device (pseudo-terminal master), b: client
+	__run_t*     run;
+	hist_t       rtt;
+	uint64_t     rounds;
+	uint64_t     sentAt;
+	uint32_t     received; // Bytes of current echo received so far
+	bool         error;
+};
+
+struct __run {
+	__port_t*     ports;
+	uint32_t      numPorts;
+	uint32_t      messageSize;
+	uint8_t       message[__MAX_MESSAGE_SIZE];
+	volatile bool stop;
+	volatile bool stopDevice;
+};
+
+// Echo device: echoes back everything received on pseudo-terminal masters
+static void* __device_run(void* arg) {
+	__run_t* run = (__run_t*)arg;
+	struct pollfd* pfds = malloc(run->numPorts * sizeof(struct pollfd));
+	uint8_t buffer[__MAX_MESSAGE_SIZE];
+
+	if (!pfds)
+		return NULL;
+
+	for (uint32_t i = 0; i < run->numPorts; i++) {
+		pfds[i].fd     = run->ports[i].pair.a.fd;
+		pfds[i].events = POLLIN;
+	}
+
+	while (!run->stopDevice) {
+		if (poll(pfds, run->numPorts, __WAIT_MILLIS) <= 0)
+			continue;
+
+		for (uint32_t i = 0; i < run->numPorts; i++) {
+			if (!(pfds[i].revents & POLLIN))
+				continue;
+
+			ssize_t mRead = read(pfds[i].fd, buffer, sizeof(buffer));
+
+			for (ssize_t written = 0, result; written < mRead; written += result) {
+				if ((result = write(pfds[i].fd, buffer + written, mRead - written)) < 0)
+					break;
+			}
+		}
+	}
+
+	free(pfds);
+	return NULL;
+}
+
+static bool __send(__port_t* port) {
+	port->received = 0;
+	port->sentAt   = bench_nanos();
+
+	if (!serial_write(port->pair.b.port, port->run->message, port->run->messageSize)) {
+		port->error = true;
+		return false;
+	}
+
+	return true;
+}
+
+// Reads available echo data (read timeout is expected to be 0)
+static bool __receive(__port_t* port) {
+	uint8_t buffer[__MAX_MESSAGE_SIZE];
+	int32_t mRead = serial_read(port->pair.b.port, buffer, port->run->messageSize - port->received);
+
+	if (mRead < 0) {
+		port->error = true;
+		return false;
+	}
+
+	port->received += (uint32_t)mRead;
+
+	if (port->received == port->run->messageSize) {
+		hist_add(&port->rtt, bench_nanos() - port->sentAt);
+		port->rounds++;
+
+		if (!port->run->stop)
+			return __send(port);
+	}
+
+	return true;
+}
+
+static void* __client_thread_run(void* arg) {
+	__port_t* port = (__port_t*)arg;
+	uint8_t buffer[__MAX_MESSAGE_SIZE];
+
+	while (!port->run->stop) {
+		if (!__send(port))
+			break;
+
+		if (serial_read(port->pair.b.port, buffer, port->run->messageSize) != (int32_t)port->run->messageSize) {
+			port->error = true;
+			break;
+		}
+
+		hist_add(&port->rtt, bench_nanos() - port->sentAt);
+		port->rounds++;
+	}
+
+	return NULL;
+}
+
+static bool __drive_threads(__run_t* run, uint64_t stopAt) {
+	pthread_t* threads = malloc(run->numPorts * sizeof(pthread_t));
+	uint32_t numThreads = 0;
+	pthread_attr_t attr;
+
+	if (!threads)
+		return false;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, __THREAD_STACK);
+
+	for (uint32_t i = 0; i < run->numPorts; i++) {
+		if (!serial_set_read_timeout(run->ports[i].pair.b.port, __READ_TIMEOUT))
+			break;
+
+		if (pthread_create(&threads[numThreads], &attr, __client_thread_run, &run->ports[i]) != 0) {
+			fprintf(stderr, "Error creating thread #%u\n", i);
+			break;
+		}
+
+		numThreads++;
+	}
+
+	pthread_attr_destroy(&attr);
+
+	while (numThreads == run->numPorts && bench_nanos() < stopAt)
+		usleep(10000);
+
+	run->stop = true;
+
+	for (uint32_t i = 0; i < numThreads; i++)
+		pthread_join(threads[i], NULL);
+
+	free(threads);
+	return numThreads == run->numPorts;
+}
+
+static bool __drive_poll(__run_t* run, uint64_t stopAt) {
+	struct pollfd* pfds = malloc(run->numPorts * sizeof(struct pollfd));
+	bool result = false;
+
+	if (!pfds)
+		return false;
+
+	for (uint32_t i = 0; i < run->numPorts; i++) {
+		pfds[i].fd     = run->ports[i].pair.b.fd;
+		pfds[i].events = POLLIN;
+
+		if (!serial_set_read_timeout(run->ports[i].pair.b.port, 0) || !__send(&run->ports[i]))
+			goto end;
+	}
+
+	while (bench_nanos() < stopAt) {
+		if (poll(pfds, run->numPorts, __WAIT_MILLIS) < 0)
+			goto end;
+
+		for (uint32_t i = 0; i < run->numPorts; i++) {
+			if ((pfds[i].revents & POLLIN) && !__receive(&run->ports[i]))
+				goto end;
+		}
+	}
+
+	result = true;
+
+end:
+	run->stop = true;
+	free(pfds);
+	return result;
+}
+
+#if __HAS_EPOLL
+static bool __drive_epoll(__run_t* run, uint64_t stopAt) {
+	struct epoll_event events[64];
+	bool result = false;
+	int epfd = epoll_create1(0);
+
+	if (epfd < 0)
+		return false;
+
+	for (uint32_t i = 0; i < run->numPorts; i++) {
+		struct epoll_event event = { .events = EPOLLIN, .data.ptr = &run->ports[i] };
+
+		if (epoll_ctl(epfd, EPOLL_CTL_ADD, run->ports[i].pair.b.fd, &event) < 0)
+			goto end;
+
+		if (!serial_set_read_timeout(run->ports[i].pair.b.port, 0) || !__send(&run->ports[i]))
+			goto end;
+	}
+
+	while (bench_nanos() < stopAt) {
+		int count = epoll_wait(epfd, events, sizeof(events) / sizeof(events[0]), __WAIT_MILLIS);
+
+		if (count < 0 && errno != EINTR)
+			goto end;
+
+		for (int i = 0; i < count; i++) {
+			if (!__receive((__port_t*)events[i].data.ptr))
+				goto end;
+		}
+	}
+
+	result = true;
+
+end:
+	run->stop = true;
+	close(epfd);
+	return result;
+}
+#endif
+
+static void __raise_fd_limit() {
+	struct rlimit limit;
+
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+static double __timeval_seconds(const struct timeval* tv) {
+	return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static bool __run(__strategy_e strategy, uint32_t numPorts, uint32_t messageSize, uint32_t durationMillis, bool csv) {
+	__run_t* run = calloc(1, sizeof(__run_t));
+	pthread_t device;
+	bool deviceStarted = false;
+	bool result = false;
+	uint32_t numOpen = 0;
+
+	if (!run || !(run->ports = calloc(numPorts, sizeof(__port_t)))) {
+		fprintf(stderr, "Out of memory\n");
+		goto end;
+	}
+
+	run->numPorts    = numPorts;
+	run->messageSize = messageSize;
+
+	for (uint32_t i = 0; i < messageSize; i++)
+		run->message[i] = (uint8_t)i;
+
+	for (; numOpen < numPorts; numOpen++) {
+		run->ports[numOpen].run = run;
+
+		if (!bench_open_pair(&run->ports[numOpen].pair, NULL, NULL, 115200)) {
+			fprintf(stderr, "Error opening port #%u (check RLIMIT_NOFILE and /proc/sys/kernel/pty/max)\n", numOpen);
+			goto end;
+		}
+	}
+
+	if (pthread_create(&device, NULL, __device_run, run) != 0) {
+		fprintf(stderr, "Error starting echo device\n");
+		goto end;
+	}
+
+	deviceStarted = true;
+
+	struct rusage usageStart, usageEnd;
+	getrusage(RUSAGE_SELF, &usageStart);
+	uint64_t start = bench_nanos();
+	bool success;
+
+	switch (strategy) {
+	case __STRATEGY_THREAD: success = __drive_threads(run, start + durationMillis * 1000000ull); break;
+	case __STRATEGY_POLL:   success = __drive_poll(run, start + durationMillis * 1000000ull); break;
+#if __HAS_EPOLL
+	case __STRATEGY_EPOLL:  success = __drive_epoll(run, start + durationMillis * 1000000ull); break;
+#endif
+	default:                success = false; break;
+	}
+
+	double elapsed = (bench_nanos() - start) / 1e9;
+	getrusage(RUSAGE_SELF, &usageEnd);
+
+	hist_t   rtt;
+	uint64_t rounds        = 0;
+	uint64_t minPortRounds = UINT64_MAX;
+	uint64_t maxPortP50    = 0;
+	uint32_t errors        = 0;
+
+	hist_clear(&rtt);
+
+	for (uint32_t i = 0; i < numPorts; i++) {
+		__port_t* port = &run->ports[i];
+		uint64_t p50 = hist_percentile(&port->rtt, 50);
+
+		hist_merge(&rtt, &port->rtt);
+		rounds += port->rounds;
+		errors += port->error ? 1 : 0;
+
+		if (port->rounds < minPortRounds)
+			minPortRounds = port->rounds;
+
+		if (p50 > maxPortP50)
+			maxPortP50 = p50;
+	}
+
+	double cpu = 100.0 * (__timeval_seconds(&usageEnd.ru_utime) + __timeval_seconds(&usageEnd.ru_stime) - __timeval_seconds(&usageStart.ru_utime) - __timeval_seconds(&usageStart.ru_stime)) / elapsed;
+	long   ctxSwitches = (usageEnd.ru_nvcsw - usageStart.ru_nvcsw) + (usageEnd.ru_nivcsw - usageStart.ru_nivcsw);
+	double roundsPerSec = rounds / elapsed;
+
+	if (csv) {
+		printf("%s,%u,%u,%.1f,%.3f,%.1f,%.1f,%.1f,%.1f,%llu,%.2f,%.1f,%u\n",
+			__STRATEGY_NAMES[strategy], numPorts, messageSize, roundsPerSec, roundsPerSec * messageSize / 1e6,
+			hist_percentile(&rtt, 50) / 1e3, hist_percentile(&rtt, 99) / 1e3, rtt.max / 1e3, maxPortP50 / 1e3,
+			(unsigned long long)minPortRounds, rounds ? (double)ctxSwitches / rounds : 0, cpu, errors);
+	} else {
+		printf("%-8s %6u %11.1f %9.3f %9.1f %9.1f %10.1f %12.1f %10llu %11.2f %7.1f %7u\n",
+			__STRATEGY_NAMES[strategy], numPorts, roundsPerSec, roundsPerSec * messageSize / 1e6,
+			hist_percentile(&rtt, 50) / 1e3, hist_percentile(&rtt, 99) / 1e3, rtt.max / 1e3, maxPortP50 / 1e3,
+			(unsigned long long)minPortRounds, rounds ? (double)ctxSwitches / rounds : 0, cpu, errors);
+	}
+
+	fflush(stdout);
+	result = success && errors == 0;
+
+end:
+	if (deviceStarted) {
+		run->stopDevice = true;
+		pthread_join(device, NULL);
+	}
+
+	if (run && run->ports) {
+		for (uint32_t i = 0; i < numOpen; i++)
+			bench_close_pair(&run->ports[i].pair);
+
+		free(run->ports);
+	}
+
+	free(run);
+	return result;
+}
+
+static void __usage(const char* cmd) {
+	printf(
+		"Usage: %s scaling [options]\n"
+		"\n"
+		"Drives N pseudo-terminal echo devices concurrently (ping-pong of a fixed\n"
+		"size message on each port) and reports aggregate throughput, round-trip\n"
+		"time distribution, context switches and CPU usage (all threads, including\n"
+		"the echo device one).\n"
+		"\n"
+		"Options:\n"
+		"  -n, --ports <list>        Number of ports (default: 1,10,100,1000)\n"
+		"  -s, --strategies <list>   thread,poll,epoll (default: all available)\n"
+		"  -S, --message-size <n>    Message size in bytes (default: 64)\n"
+		"  -d, --duration <ms>       Duration of each run (default: 2000)\n"
+		"      --csv                 CSV output\n",
+		cmd
+	);
+}
+
+int bench_scaling(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "ports",        required_argument, NULL, 'n' },
+		{ "strategies",   required_argument, NULL, 's' },
+		{ "message-size", required_argument, NULL, 'S' },
+		{ "duration",     required_argument, NULL, 'd' },
+		{ "csv",          no_argument,       NULL, 'C' },
+		{ "help",         no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	uint32_t ports[__MAX_ITEMS] = { 1, 10, 100, 1000 };
+	int      numPortCounts = 4;
+	uint32_t messageSize   = 64;
+	uint32_t duration      = 2000;
+	bool     csv           = false;
+	bool     strategies[__STRATEGY_COUNT] = { true, true, __HAS_EPOLL };
+	int      opt;
+
+	while ((opt = getopt_long(argc, argv, "n:s:S:d:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'n': numPortCounts = bench_parse_list(optarg, ports, __MAX_ITEMS); break;
+		case 'S': messageSize = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'd': duration = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'C': csv = true; break;
+
+		case 's':
+			for (int i = 0; i < __STRATEGY_COUNT; i++)
+				strategies[i] = strstr(optarg, __STRATEGY_NAMES[i]) != NULL;
+
+			if (strategies[__STRATEGY_EPOLL] && !__HAS_EPOLL) {
+				fprintf(stderr, "epoll is not available\n");
+				return 1;
+			}
+			break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (numPortCounts <= 0 || messageSize == 0 || messageSize > __MAX_MESSAGE_SIZE) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	__raise_fd_limit();
+
+	if (csv) {
+		printf("strategy,ports,rounds_per_s,mb_per_s,p50_us,p99_us,max_us,worst_port_p50_us,min_port_rounds,ctx_switches_per_round,cpu_percent,failed_ports\n");
+	} else {
+		printf("%-8s %6s %11s %9s %9s %9s %10s %12s %10s %11s %7s %7s\n",
+			"strategy", "ports", "rounds/s", "MB/s", "p50(us)", "p99(us)", "max(us)", "worst p50", "min rounds", "ctxsw/round", "CPU%", "failed");
+	}
+
+	int exitCode = 0;
+
+	for (int s = 0; s < __STRATEGY_COUNT; s++) {
+		if (!strategies[s])
+			continue;
+
+		for (int n = 0; n < numPortCounts; n++) {
+			if (ports[n] == 0)
+				continue;
+
+			if (!__run((__strategy_e)s, ports[n], messageSize, duration, csv))
+				exitCode = 1;
+		}
+	}
+
+	return exitCode;
+}
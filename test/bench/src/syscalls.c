@@ -0,0 +1,113 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "syscalls.h"
+
+#include <stdarg.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/uio.h>
+
+// Wrapped symbols are resolved at link time (see -Wl,--wrap on Makefile)
+
+static uint64_t __count = 0;
+
+#define __COUNT() __atomic_fetch_add(&__count, 1, __ATOMIC_RELAXED)
+
+ssize_t __real_read(int fd, void* buf, size_t count);
+ssize_t __real_write(int fd, const void* buf, size_t count);
+ssize_t __real_writev(int fd, const struct iovec* iov, int iovcnt);
+int __real_poll(struct pollfd* fds, nfds_t nfds, int timeout);
+int __real_ioctl(int fd, unsigned long request, void* arg);
+int __real_fcntl(int fd, int cmd, void* arg);
+int __real_tcgetattr(int fd, struct termios* termios);
+int __real_tcsetattr(int fd, int actions, const struct termios* termios);
+int __real_tcflush(int fd, int queueSelector);
+int __real_tcdrain(int fd);
+
+ssize_t __wrap_read(int fd, void* buf, size_t count) {
+	__COUNT();
+	return __real_read(fd, buf, count);
+}
+
+ssize_t __wrap_write(int fd, const void* buf, size_t count) {
+	__COUNT();
+	return __real_write(fd, buf, count);
+}
+
+ssize_t __wrap_writev(int fd, const struct iovec* iov, int iovcnt) {
+	__COUNT();
+	return __real_writev(fd, iov, iovcnt);
+}
+
+int __wrap_poll(struct pollfd* fds, nfds_t nfds, int timeout) {
+	__COUNT();
+	return __real_poll(fds, nfds, timeout);
+}
+
+int __wrap_ioctl(int fd, unsigned long request, ...) {
+	va_list ap;
+	va_start(ap, request);
+	void* arg = va_arg(ap, void*);
+	va_end(ap);
+
+	__COUNT();
+	return __real_ioctl(fd, request, arg);
+}
+
+int __wrap_fcntl(int fd, int cmd, ...) {
+	va_list ap;
+	va_start(ap, cmd);
+	void* arg = va_arg(ap, void*);
+	va_end(ap);
+
+	__COUNT();
+	return __real_fcntl(fd, cmd, arg);
+}
+
+int __wrap_tcgetattr(int fd, struct termios* termios) {
+	__COUNT();
+	return __real_tcgetattr(fd, termios);
+}
+
+int __wrap_tcsetattr(int fd, int actions, const struct termios* termios) {
+	__COUNT();
+	return __real_tcsetattr(fd, actions, termios);
+}
+
+int __wrap_tcflush(int fd, int queueSelector) {
+	__COUNT();
+	return __real_tcflush(fd, queueSelector);
+}
+
+int __wrap_tcdrain(int fd) {
+	__COUNT();
+	return __real_tcdrain(fd);
+}
+
+void syscalls_reset() {
+	__atomic_store_n(&__count, 0, __ATOMIC_RELAXED);
+}
+
+uint64_t syscalls_count() {
+	return __atomic_load_n(&__count, __ATOMIC_RELAXED);
+}
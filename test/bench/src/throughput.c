@@ -0,0 +1,383 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include "bench.h"
+#include "syscalls.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/uio.h>
+
+#define __MAX_ITEMS        16
+#define __IOV_COUNT        16
+#define __PATTERN_PERIOD   251 // Prime, so that chunk boundaries do not align with the pattern
+#define __DRAIN_TIMEOUT_NS 2000000000ull
+
+typedef enum __write_mode __write_mode_e;
+typedef struct __writer __writer_t;
+typedef struct __result __result_t;
+
+enum __write_mode {
+	__WRITE_MODE_SERIAL, // serial_write() of each chunk
+	__WRITE_MODE_WRITEV  // Raw writev() of __IOV_COUNT chunks (baseline without the library)
+};
+
+static const char* __WRITE_MODE_NAMES[] = { "serial", "writev" };
+
+struct __writer {
+	bench_endpoint_t* endpoint;
+	__write_mode_e    mode;
+	uint32_t          chunk;
+	uint8_t*          pattern;
+	volatile bool     stop;
+	volatile bool     done;
+	uint64_t          written;
+	bool              error;
+};
+
+struct __result {
+	double   mbps;
+	double   syscallsPerMb;
+	double   cpu;
+	uint64_t bytes;
+	uint64_t errors; // Corrupted or lost bytes
+};
+
+static bool __write_all_raw(int fd, struct iovec* iov, int iovcnt, uint64_t* written) {
+	while (iovcnt > 0) {
+		ssize_t result = writev(fd, iov, iovcnt);
+
+		if (result < 0) {
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN) {
+				struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+				poll(&pfd, 1, -1);
+				continue;
+			}
+
+			return false;
+		}
+
+		*written += (uint64_t)result;
+
+		while (iovcnt > 0 && (size_t)result >= iov->iov_len) {
+			result -= (ssize_t)iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if (iovcnt > 0) {
+			iov->iov_base = (uint8_t*)iov->iov_base + result;
+			iov->iov_len -= (size_t)result;
+		}
+	}
+
+	return true;
+}
+
+static void* __writer_run(void* arg) {
+	__writer_t* writer = (__writer_t*)arg;
+
+	while (!writer->stop) {
+		const uint8_t* data = writer->pattern + (writer->written % __PATTERN_PERIOD);
+
+		if (writer->mode == __WRITE_MODE_SERIAL) {
+			if (!serial_write(writer->endpoint->port, data, writer->chunk)) {
+				writer->error = true;
+				break;
+			}
+
+			writer->written += writer->chunk;
+		} else {
+			struct iovec iov[__IOV_COUNT];
+
+			for (int i = 0; i < __IOV_COUNT; i++) {
+				iov[i].iov_base = (void*)(data + (size_t)i * writer->chunk);
+				iov[i].iov_len  = writer->chunk;
+			}
+
+			if (!__write_all_raw(writer->endpoint->fd, iov, __IOV_COUNT, &writer->written)) {
+				writer->error = true;
+				break;
+			}
+		}
+	}
+
+	__atomic_store_n(&writer->done, true, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static double __cpu_seconds() {
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+	return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static bool __run(bench_pair_t* pair, __write_mode_e mode, uint32_t chunk, uint32_t readSize, uint32_t timeout, uint32_t durationMillis, __result_t* result) {
+	size_t   szPattern = (size_t)chunk * __IOV_COUNT + __PATTERN_PERIOD;
+	uint8_t* pattern   = malloc(szPattern);
+	uint8_t* buffer    = malloc(readSize);
+	bool     success   = false;
+
+	if (!pattern || !buffer) {
+		fprintf(stderr, "Out of memory\n");
+		goto end;
+	}
+
+	for (size_t i = 0; i < szPattern; i++)
+		pattern[i] = (uint8_t)(i % __PATTERN_PERIOD);
+
+	if (!serial_set_read_timeout(pair->b.port, timeout) || !serial_purge(pair->b.port, SERIAL_PURGE_TYPE_RX_TX)) {
+		fprintf(stderr, "Error preparing reader: %s\n", serial_error_to_str(errno));
+		goto end;
+	}
+
+	__writer_t writer = {
+		.endpoint = &pair->a,
+		.mode     = mode,
+		.chunk    = chunk,
+		.pattern  = pattern
+	};
+
+	memset(result, 0, sizeof(__result_t));
+
+	pthread_t thread;
+	syscalls_reset();
+	double   cpuStart  = __cpu_seconds();
+	uint64_t start     = bench_nanos();
+	uint64_t stopAt    = start + durationMillis * 1000000ull;
+	uint64_t lastData  = start;
+	uint64_t expected  = 0; // Position of next byte in the pattern
+	uint64_t now;
+
+	if (pthread_create(&thread, NULL, __writer_run, &writer) != 0) {
+		fprintf(stderr, "Error starting writer thread\n");
+		goto end;
+	}
+
+	while (true) {
+		errno = 0;
+		int32_t mRead = serial_read(pair->b.port, buffer, readSize);
+		now = bench_nanos();
+
+		if (mRead > 0) {
+			for (int32_t i = 0; i < mRead; i++) {
+				if (buffer[i] != (uint8_t)((expected + (uint64_t)i) % __PATTERN_PERIOD))
+					result->errors++;
+			}
+
+			expected += (uint64_t)mRead;
+			lastData  = now;
+		} else if (mRead < 0 && errno != SERIAL_ERROR_TIMEOUT) {
+			fprintf(stderr, "Error reading: %s\n", serial_error_to_str(errno));
+			writer.stop = true;
+			break;
+		}
+
+		if (now >= stopAt)
+			writer.stop = true;
+
+		if (__atomic_load_n(&writer.done, __ATOMIC_ACQUIRE)) {
+			if (expected >= writer.written)
+				break;
+
+			if (now - lastData > __DRAIN_TIMEOUT_NS) {
+				result->errors += writer.written - expected; // Lost data
+				break;
+			}
+		}
+	}
+
+	pthread_join(thread, NULL);
+
+	if (writer.error) {
+		fprintf(stderr, "Error writing: %s\n", serial_error_to_str(errno));
+		goto end;
+	}
+
+	double elapsed = (now - start) / 1e9;
+	double mb      = expected / 1e6;
+
+	result->bytes         = expected;
+	result->mbps          = mb / elapsed;
+	result->syscallsPerMb = mb > 0 ? syscalls_count() / mb : 0;
+	result->cpu           = 100.0 * (__cpu_seconds() - cpuStart) / elapsed;
+	success = true;
+
+end:
+	free(pattern);
+	free(buffer);
+	return success;
+}
+
+static void __usage(const char* cmd) {
+	printf(
+		"Usage: %s throughput [options]\n"
+		"\n"
+		"Streams data between two endpoints and reports throughput, system calls\n"
+		"per MB and CPU usage (all threads) for each combination of parameters.\n"
+		"\n"
+		"Options:\n"
+		"  -a, --port-a <name>      Writer port (default: pseudo-terminal master)\n"
+		"  -b, --port-b <name>      Reader port (default: port A looped back, or\n"
+		"                           pseudo-terminal slave)\n"
+		"  -B, --baud <baud>        Baud rate (default: 115200)\n"
+		"  -d, --duration <ms>      Duration of each run (default: 1000)\n"
+		"  -c, --chunks <list>      Write chunk sizes (default: 1,16,256,4096)\n"
+		"  -r, --read-sizes <list>  Read buffer sizes (default: 64,4096,65536)\n"
+		"  -t, --timeouts <list>    Read timeouts in ms (0: non-blocking; default: 0,100)\n"
+		"  -m, --modes <list>       Write modes: serial,writev (default: both)\n"
+		"      --csv                CSV output\n",
+		cmd
+	);
+}
+
+int bench_throughput(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "port-a",     required_argument, NULL, 'a' },
+		{ "port-b",     required_argument, NULL, 'b' },
+		{ "baud",       required_argument, NULL, 'B' },
+		{ "duration",   required_argument, NULL, 'd' },
+		{ "chunks",     required_argument, NULL, 'c' },
+		{ "read-sizes", required_argument, NULL, 'r' },
+		{ "timeouts",   required_argument, NULL, 't' },
+		{ "modes",      required_argument, NULL, 'm' },
+		{ "csv",        no_argument,       NULL, 'C' },
+		{ "help",       no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	const char* portA    = NULL;
+	const char* portB    = NULL;
+	uint32_t    baud     = 115200;
+	uint32_t    duration = 1000;
+	bool        csv      = false;
+	uint32_t    chunks[__MAX_ITEMS]    = { 1, 16, 256, 4096 };
+	uint32_t    readSizes[__MAX_ITEMS] = { 64, 4096, 65536 };
+	uint32_t    timeouts[__MAX_ITEMS]  = { 0, 100 };
+	bool        modes[2]               = { true, true };
+	int         numChunks    = 4;
+	int         numReadSizes = 3;
+	int         numTimeouts  = 2;
+	int         opt;
+
+	while ((opt = getopt_long(argc, argv, "a:b:B:d:c:r:t:m:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'a': portA = optarg; break;
+		case 'b': portB = optarg; break;
+		case 'B': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'd': duration = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'c': numChunks = bench_parse_list(optarg, chunks, __MAX_ITEMS); break;
+		case 'r': numReadSizes = bench_parse_list(optarg, readSizes, __MAX_ITEMS); break;
+		case 't': numTimeouts = bench_parse_list(optarg, timeouts, __MAX_ITEMS); break;
+		case 'C': csv = true; break;
+
+		case 'm':
+			modes[__WRITE_MODE_SERIAL] = strstr(optarg, __WRITE_MODE_NAMES[__WRITE_MODE_SERIAL]) != NULL;
+			modes[__WRITE_MODE_WRITEV] = strstr(optarg, __WRITE_MODE_NAMES[__WRITE_MODE_WRITEV]) != NULL;
+			break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (numChunks <= 0 || numReadSizes <= 0 || numTimeouts <= 0 || (portB && !portA)) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	for (int i = 0; i < numChunks; i++) {
+		if (chunks[i] == 0) {
+			fprintf(stderr, "Invalid chunk size: 0\n");
+			return 1;
+		}
+	}
+
+	for (int i = 0; i < numReadSizes; i++) {
+		if (readSizes[i] == 0) {
+			fprintf(stderr, "Invalid read size: 0\n");
+			return 1;
+		}
+	}
+
+	bench_pair_t pair;
+
+	if (!bench_open_pair(&pair, portA, portB, baud))
+		return 1;
+
+	if (csv) {
+		printf("mode,chunk,read_size,timeout_ms,bytes,mb_per_s,syscalls_per_mb,cpu_percent,errors\n");
+	} else {
+		printf("%s -> %s\n\n", serial_get_name(pair.a.port), serial_get_name(pair.b.port));
+		printf("%-7s %7s %7s %8s %10s %13s %7s %8s\n", "mode", "chunk", "read", "timeout", "MB/s", "syscalls/MB", "CPU%", "errors");
+	}
+
+	int exitCode = 0;
+
+	for (int m = 0; m < 2; m++) {
+		if (!modes[m])
+			continue;
+
+		for (int c = 0; c < numChunks; c++) {
+			for (int r = 0; r < numReadSizes; r++) {
+				for (int t = 0; t < numTimeouts; t++) {
+					__result_t result;
+
+					if (!__run(&pair, (__write_mode_e)m, chunks[c], readSizes[r], timeouts[t], duration, &result)) {
+						exitCode = 1;
+						goto end;
+					}
+
+					if (result.errors)
+						exitCode = 1;
+
+					if (csv) {
+						printf("%s,%u,%u,%u,%llu,%.3f,%.1f,%.1f,%llu\n", __WRITE_MODE_NAMES[m], chunks[c], readSizes[r], timeouts[t], (unsigned long long)result.bytes, result.mbps, result.syscallsPerMb, result.cpu, (unsigned long long)result.errors);
+					} else {
+						printf("%-7s %7u %7u %8u %10.3f %13.1f %7.1f %8llu\n", __WRITE_MODE_NAMES[m], chunks[c], readSizes[r], timeouts[t], result.mbps, result.syscallsPerMb, result.cpu, (unsigned long long)result.errors);
+					}
+
+					fflush(stdout);
+				}
+			}
+		}
+	}
+
+end:
+	bench_close_pair(&pair);
+	return exitCode;
+}
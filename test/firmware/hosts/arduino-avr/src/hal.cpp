@@ -79,6 +79,23 @@ int32_t hal::serial::read(void* out, uint32_t len) {
 	return Serial.readBytes((uint8_t*)out, len);
 }
 
+int32_t hal::serial::discard(uint32_t maxBytes, uint32_t idleMillis) {
+	int32_t discarded = 0;
+	uint32_t lastData = ::millis();
+
+	while (maxBytes == 0 || (uint32_t)discarded < maxBytes) {
+		if (Serial.available() > 0) {
+			Serial.read();
+			discarded++;
+			lastData = ::millis();
+		} else if (::millis() - lastData >= idleMillis) {
+			break;
+		}
+	}
+
+	return discarded;
+}
+
 bool hal::serial::write(const void* in, uint32_t len) {
 	Serial.write((uint8_t*)in, len);
 	return true;
@@ -21,7 +21,7 @@
 # libserial ====================================================================
 LIBSERIAL_DIR  := ../..
 PRE_BUILD_DEPS += $(O)/libs/libserial.marker
-LDFLAGS        += -lserial0
+LDFLAGS        += -lserial0 -pthread
 
 --libserial:
 	$(O_VERBOSE)$(MAKE) -C $(LIBSERIAL_DIR) O=$(call FN_REL_DIR,$(LIBSERIAL_DIR),$(O)/libs) BUILD_SUBDIR=libserial DIST_MARKER=libserial.marker LIB_TYPE=static
@@ -246,6 +246,16 @@ int32_t hal::serial::read(void* out, uint32_t len) {
 	return serial_read(port, out, len);
 }
 
+int32_t hal::serial::discard(uint32_t maxBytes, uint32_t idleMillis) {
+	serial_t* port = hal::serial::open();
+	if (!port) {
+		errno = SERIAL_ERROR_IO;
+		return -1;
+	}
+
+	return serial_discard(port, maxBytes, idleMillis);
+}
+
 bool hal::serial::write(const void* in, uint32_t len) {
 	serial_t* port = hal::serial::open();
 	if (!port) {
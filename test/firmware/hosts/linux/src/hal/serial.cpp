@@ -23,6 +23,7 @@ SOFTWARE.
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 
 static serial_t* __port = NULL;
 
@@ -141,6 +142,17 @@ error:
 	return NULL;
 }
 
+serial_t* hal::serial::open(const char* portName) {
+	if (!__port) {
+		__port = serial_open(portName);
+
+		if (!__port)
+			printf("Error opening %s: %s\n", portName, serial_error_to_str((serial_error_e)errno));
+	}
+
+	return __port;
+}
+
 bool hal::serial::close() {
 	if (__port) {
 		if (serial_close(__port)) {
@@ -27,6 +27,9 @@ namespace hal {
 	namespace serial {
 		serial_t* open();
 
+		/** Opens given port (instead of choosing it from available ones). */
+		serial_t* open(const char* portName);
+
 		bool close();
 
 	} // namespace serial
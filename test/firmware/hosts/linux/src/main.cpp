@@ -40,13 +40,14 @@ static void __onSignal(int sgn) {
 	}
 }
 
-int main() {
+int main(int argc, char** argv) {
 	signal(SIGTERM, __onSignal);
 	signal(SIGABRT, __onSignal);
 	signal(SIGSEGV, __onSignal);
 	signal(SIGINT, __onSignal);
 
-	if (!hal::serial::open()) return 1;
+	// Port can be given as argument (e.g. one end of a pseudo-terminal pair)
+	if (!(argc > 1 ? hal::serial::open(argv[1]) : hal::serial::open())) return 1;
 
 	led::init();
 	comm::init();
@@ -36,10 +36,12 @@ SOFTWARE.
 #define __MSG_PING       "PING"
 #define __MSG_PROT       "PROT"
 #define __MSG_BLINK      "BLINK"
+#define __MSG_SYNC       "SYNC"
 
 #define __PACKET_PING 2
 #define __PACKET_PROT 3
 #define __PACKET_DBG  4
+#define __PACKET_SYNC 5
 
 #define __READ_TIMEOUT_MILLIS 1000
 #define __MSG_MAX_LEN         128
@@ -75,9 +77,10 @@ static bool COMM_CALL __flush(comm_stream_t* stream) {
 	return hal::serial::flush();
 }
 
+// Drops only what is already buffered: waiting for the line to become idle
+// would never end while the host keeps retrying its sync.
 static void __purge() {
-	uint8_t b;
-	while(hal::serial::read(&b, 1) > 0);
+	hal::serial::discard(0, 0);
 }
 
 #if DEBUG_ENABLED
@@ -132,11 +135,13 @@ void comm::init(unsigned long speed, const hal::serial::Config& cfg, Mode mode)
 		{ __MSG_PROT , message::PROT  },
 		{ __MSG_PING , message::PING  },
 		{ __MSG_BLINK, message::BLINK },
+		{ __MSG_SYNC , message::SYNC  },
 		{ nullptr, nullptr }
 	};
 	static const dispatcher::PacketHandler mPacketHandlers[] = {
 		{ __PACKET_PROT, packet::PROT },
 		{ __PACKET_PING, packet::PING },
+		{ __PACKET_SYNC, packet::SYNC },
 		{ 0, nullptr }
 	};
 
@@ -63,6 +63,8 @@ namespace serial {
 
 	int32_t read(void* out, uint32_t len);
 
+	int32_t discard(uint32_t maxBytes, uint32_t idleMillis);
+
 	bool write(const void* in, uint32_t len);
 
 	bool flush();
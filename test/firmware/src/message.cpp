@@ -169,6 +169,11 @@ nak:
 	comm::write(__NAK);
 }
 
+void message::SYNC(const char* id, char* data) {
+	// Echoed marker tells the host where stale data ends
+	comm::write(data);
+}
+
 void message::noHandler(const char* id, char* data) {
 	comm::write(__NAK);
 }
@@ -30,5 +30,7 @@ namespace message {
 
 	void BLINK(const char* id, char* data);
 
+	void SYNC(const char* id, char* data);
+
 	void noHandler(const char* id, char* data);
 };
@@ -24,6 +24,7 @@ SOFTWARE.
 #include "debug.hpp"
 
 #include <comm.h>
+#include <string.h>
 
 #define __ACK        0
 #define __NAK        1
@@ -189,6 +190,21 @@ nak:
 	__sendAck(false);
 }
 
+void packet::SYNC(uint8_t id, void* data, uint8_t szData) {
+	// Echoed packet (including id) tells the host where stale data ends
+	static uint8_t packet[UINT8_MAX];
+
+	if (szData > sizeof(packet) - 1) {
+		// Echo (id + data) would not fit into a packet
+		__sendAck(false);
+		return;
+	}
+
+	packet[0] = id;
+	memcpy(packet + 1, data, szData);
+	comm::write(packet, (uint8_t)(szData + 1));
+}
+
 void packet::noHandler(uint8_t id, void* data, uint8_t szData) {
 	__sendAck(false);
 }
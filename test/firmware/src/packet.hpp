@@ -28,5 +28,7 @@ namespace packet {
 
 	void PROT(uint8_t id,void* data, uint8_t szData);
 
+	void SYNC(uint8_t id, void* data, uint8_t szData);
+
 	void noHandler(uint8_t id,void* data, uint8_t szData);
 };
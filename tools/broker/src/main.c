@@ -0,0 +1,186 @@
+/*
+Copyright (c) 2022 Leandro José Britto de Oliveira
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#include <serial.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct __entry __entry_t;
+
+// A port served by its own broker thread
+struct __entry {
+	const char*      portName;
+	const char*      socketPath;
+	serial_t*        port;
+	serial_broker_t* broker;
+	pthread_t        thread;
+	bool             started;
+};
+
+static pthread_mutex_t __mutex   = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t        __running = 0;
+
+static void __usage(const char* cmd) {
+	printf(
+		"Usage: %s [options] <port> <socket> [<port> <socket> ...]\n"
+		"\n"
+		"Owns serial ports and shares them with local clients, which open\n"
+		"them as 'broker://<socket>'. Received data is published into a\n"
+		"shared memory ring mapped read-only by every client, and data\n"
+		"written by clients is sent to the port one message at a time.\n"
+		"\n"
+		"Options:\n"
+		"  -b, --baud <baud>        Baud rate (default: 9600, 8N1)\n"
+		"  -r, --ring-size <bytes>  Shared ring size (default: 1 MiB)\n",
+		cmd
+	);
+}
+
+static void* __run(void* arg) {
+	__entry_t* entry = (__entry_t*)arg;
+
+	if (!serial_broker_run(entry->broker))
+		fprintf(stderr, "%s: %s\n", entry->portName, serial_error_to_str(errno));
+
+	// Process ends when every broker has stopped
+	pthread_mutex_lock(&__mutex);
+	if (--__running == 0)
+		kill(getpid(), SIGTERM);
+	pthread_mutex_unlock(&__mutex);
+
+	return NULL;
+}
+
+int main(int argc, char** argv) {
+	static const struct option options[] = {
+		{ "baud",      required_argument, NULL, 'b' },
+		{ "ring-size", required_argument, NULL, 'r' },
+		{ "help",      no_argument,       NULL, 'h' },
+		{ NULL, 0, NULL, 0 }
+	};
+
+	serial_config_t config = { 9600, SERIAL_DATA_BITS_8, SERIAL_PARITY_NONE, SERIAL_STOP_BITS_1 };
+	uint32_t ringSize = 0;
+	int      exitCode = 1;
+	int      opt;
+
+	while ((opt = getopt_long(argc, argv, "b:r:h", options, NULL)) != -1) {
+		switch (opt) {
+		case 'b': config.baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+		case 'r': ringSize = (uint32_t)strtoul(optarg, NULL, 10); break;
+
+		case 'h':
+			__usage(argv[0]);
+			return 0;
+
+		default:
+			__usage(argv[0]);
+			return 1;
+		}
+	}
+
+	int count = (argc - optind) / 2;
+
+	if (count == 0 || (argc - optind) % 2 != 0 || config.baud == 0) {
+		__usage(argv[0]);
+		return 1;
+	}
+
+	__entry_t* entries = calloc((size_t)count, sizeof(__entry_t));
+
+	if (!entries) {
+		fprintf(stderr, "Out of memory\n");
+		return 1;
+	}
+
+	// Signals are handled by main thread only (see sigwait() below)
+	sigset_t signals;
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGINT);
+	sigaddset(&signals, SIGTERM);
+	pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+	for (int i = 0; i < count; i++) {
+		__entry_t* entry = &entries[i];
+		entry->portName   = argv[optind + 2 * i];
+		entry->socketPath = argv[optind + 2 * i + 1];
+
+		if (!(entry->port = serial_open(entry->portName)) || !serial_config(entry->port, &config)) {
+			fprintf(stderr, "Error opening %s: %s\n", entry->portName, serial_error_to_str(errno));
+			goto end;
+		}
+
+		if (!(entry->broker = serial_broker_new(entry->port, entry->socketPath, ringSize))) {
+			fprintf(stderr, "Error creating broker on %s: %s\n", entry->socketPath, serial_error_to_str(errno));
+			goto end;
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		pthread_mutex_lock(&__mutex);
+		__running++;
+		pthread_mutex_unlock(&__mutex);
+
+		if (pthread_create(&entries[i].thread, NULL, __run, &entries[i]) != 0) {
+			fprintf(stderr, "Error starting broker thread\n");
+			pthread_mutex_lock(&__mutex);
+			__running--;
+			pthread_mutex_unlock(&__mutex);
+			goto end;
+		}
+
+		entries[i].started = true;
+		printf("%s -> broker://%s\n", entries[i].portName, entries[i].socketPath);
+	}
+
+	fflush(stdout);
+
+	int signal;
+	sigwait(&signals, &signal);
+	exitCode = 0;
+
+end:
+	for (int i = 0; i < count; i++) {
+		if (entries[i].started) {
+			serial_broker_stop(entries[i].broker);
+			pthread_join(entries[i].thread, NULL);
+		}
+	}
+
+	for (int i = 0; i < count; i++) {
+		if (entries[i].broker)
+			serial_broker_del(entries[i].broker);
+
+		if (entries[i].port)
+			serial_close(entries[i].port);
+	}
+
+	free(entries);
+	return exitCode;
+}